@@ -0,0 +1,614 @@
+#pragma once
+
+// Flat, open addressing hash map and set, meant for tables keyed by addresses (peer tables, per-client state).
+//
+// Entries are stored inline in a single array, next to a separate array of 1-byte control words that hold
+// 7 bits of each key's hash. Lookups scan the control bytes 8 at a time, and only compare keys whose hash bits
+// match, so a lookup usually touches one control word and one entry. Erasing leaves a tombstone only when needed.
+//
+// Unlike std::unordered_map, references and iterators are invalidated by any insertion that grows the table,
+// and the hash function must spread its result over all bits (the std::hash specializations of qsox types do).
+
+#include "Hash.hpp"
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace qsox {
+
+namespace detail {
+
+// Control byte values, full slots store the low 7 bits of the hash of their key
+constexpr uint8_t CtrlEmpty = 0x80;
+constexpr uint8_t CtrlDeleted = 0xfe;
+
+constexpr size_t GroupSize = 8;
+constexpr uint64_t GroupLsb = 0x0101010101010101ull;
+constexpr uint64_t GroupMsb = 0x8080808080808080ull;
+
+// Each function returns a mask with the high bit set in every matching byte of a group of 8 control bytes.
+// The first one may report false positives after a true match, those are filtered out by comparing keys.
+
+inline uint64_t groupMatch(uint64_t group, uint8_t tag) {
+    uint64_t x = group ^ (GroupLsb * tag);
+    return (x - GroupLsb) & ~x & GroupMsb;
+}
+
+inline uint64_t groupEmpty(uint64_t group) {
+    // bit 6 is only clear in empty bytes
+    return group & ~(group << 1) & GroupMsb;
+}
+
+inline uint64_t groupEmptyOrDeleted(uint64_t group) {
+    return group & GroupMsb;
+}
+
+inline size_t groupFirst(uint64_t mask) {
+    return static_cast<size_t>(std::countr_zero(mask)) / 8;
+}
+
+// Shared implementation of AddressMap and AddressSet, `KeyOf::get` returns the key of a slot
+template <typename Slot, typename Key, typename KeyOf, typename Hash, typename Eq>
+class FlatTable {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    FlatTable() = default;
+
+    FlatTable(const FlatTable& other) : m_hash(other.m_hash), m_eq(other.m_eq) {
+        this->reserve(other.m_size);
+
+        for (size_t i = 0; i < other.m_capacity; i++) {
+            if (other.isFull(i)) {
+                this->insertUnique(other.m_slots[i]);
+            }
+        }
+    }
+
+    FlatTable(FlatTable&& other) noexcept
+        : m_ctrl(std::exchange(other.m_ctrl, nullptr)),
+          m_slots(std::exchange(other.m_slots, nullptr)),
+          m_capacity(std::exchange(other.m_capacity, 0)),
+          m_size(std::exchange(other.m_size, 0)),
+          m_growthLeft(std::exchange(other.m_growthLeft, 0)),
+          m_hash(std::move(other.m_hash)),
+          m_eq(std::move(other.m_eq)) {}
+
+    FlatTable& operator=(FlatTable other) noexcept {
+        this->swap(other);
+        return *this;
+    }
+
+    ~FlatTable() {
+        this->destroyAll();
+        this->deallocate(m_ctrl, m_slots, m_capacity);
+    }
+
+    void swap(FlatTable& other) noexcept {
+        std::swap(m_ctrl, other.m_ctrl);
+        std::swap(m_slots, other.m_slots);
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_size, other.m_size);
+        std::swap(m_growthLeft, other.m_growthLeft);
+        std::swap(m_hash, other.m_hash);
+        std::swap(m_eq, other.m_eq);
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+    size_t capacity() const {
+        return m_capacity;
+    }
+
+    bool isFull(size_t index) const {
+        return (m_ctrl[index] & 0x80) == 0;
+    }
+
+    Slot* slotAt(size_t index) const {
+        return m_slots + index;
+    }
+
+    // Returns the index of the slot holding `key`, or `npos`
+    size_t findIndex(const Key& key) const {
+        if (m_size == 0) {
+            return npos;
+        }
+
+        uint64_t h = this->hashOf(key);
+        uint8_t tag = h & 0x7f;
+        size_t groupMask = m_capacity / GroupSize - 1;
+        size_t group = (h >> 7) & groupMask;
+
+        for (size_t step = 1;; step++) {
+            uint64_t word = this->loadGroup(group);
+
+            for (uint64_t m = groupMatch(word, tag); m != 0; m &= m - 1) {
+                size_t index = group * GroupSize + groupFirst(m);
+                if (m_eq(KeyOf::get(m_slots[index]), key)) {
+                    return index;
+                }
+            }
+
+            if (groupEmpty(word) != 0) {
+                return npos;
+            }
+
+            // triangular probing, visits every group when the group count is a power of 2
+            group = (group + step) & groupMask;
+        }
+    }
+
+    // Finds the slot for `key`, or inserts one constructed with `construct(Slot*)`.
+    // Returns the slot index and whether it was inserted.
+    template <typename F>
+    std::pair<size_t, bool> findOrInsert(const Key& key, F&& construct) {
+        size_t index = this->findIndex(key);
+        if (index != npos) {
+            return {index, false};
+        }
+
+        if (m_capacity == 0) {
+            this->grow();
+        }
+
+        uint64_t h = this->hashOf(key);
+        index = this->findInsertSlot(h);
+
+        if (m_growthLeft == 0 && m_ctrl[index] == CtrlEmpty) {
+            this->grow();
+            index = this->findInsertSlot(h);
+        }
+
+        construct(m_slots + index);
+
+        m_growthLeft -= m_ctrl[index] == CtrlEmpty;
+        m_ctrl[index] = h & 0x7f;
+        m_size++;
+
+        return {index, true};
+    }
+
+    void eraseAt(size_t index) {
+        std::destroy_at(m_slots + index);
+        m_size--;
+
+        // If this group still has an empty slot, no probe sequence ever continued past it,
+        // so the slot can become empty again instead of a tombstone.
+        if (groupEmpty(this->loadGroup(index / GroupSize)) != 0) {
+            m_ctrl[index] = CtrlEmpty;
+            m_growthLeft++;
+        } else {
+            m_ctrl[index] = CtrlDeleted;
+        }
+    }
+
+    void clear() {
+        this->destroyAll();
+
+        if (m_capacity > 0) {
+            memset(m_ctrl, CtrlEmpty, m_capacity);
+        }
+
+        m_size = 0;
+        m_growthLeft = maxLoad(m_capacity);
+    }
+
+    // Makes sure `count` elements fit without growing
+    void reserve(size_t count) {
+        if (count <= m_size + m_growthLeft) {
+            return;
+        }
+
+        size_t capacity = GroupSize * 2;
+        while (maxLoad(capacity) < count) {
+            capacity *= 2;
+        }
+
+        this->rehash(std::max(capacity, m_capacity));
+    }
+
+private:
+    uint8_t* m_ctrl = nullptr;
+    Slot* m_slots = nullptr;
+    size_t m_capacity = 0;
+    size_t m_size = 0;
+    size_t m_growthLeft = 0;
+    [[no_unique_address]] Hash m_hash;
+    [[no_unique_address]] Eq m_eq;
+
+    // Tables are kept at most 7/8 full
+    static size_t maxLoad(size_t capacity) {
+        return capacity - capacity / 8;
+    }
+
+    uint64_t hashOf(const Key& key) const {
+        return static_cast<uint64_t>(m_hash(key));
+    }
+
+    uint64_t loadGroup(size_t group) const {
+        uint64_t word;
+        memcpy(&word, m_ctrl + group * GroupSize, sizeof(word));
+        return word;
+    }
+
+    // Returns the first empty or deleted slot in the probe sequence of `h`. The table must not be full.
+    size_t findInsertSlot(uint64_t h) const {
+        size_t groupMask = m_capacity / GroupSize - 1;
+        size_t group = (h >> 7) & groupMask;
+
+        for (size_t step = 1;; step++) {
+            uint64_t m = groupEmptyOrDeleted(this->loadGroup(group));
+            if (m != 0) {
+                return group * GroupSize + groupFirst(m);
+            }
+
+            group = (group + step) & groupMask;
+        }
+    }
+
+    void insertUnique(const Slot& slot) {
+        uint64_t h = this->hashOf(KeyOf::get(slot));
+        size_t index = this->findInsertSlot(h);
+
+        std::construct_at(m_slots + index, slot);
+        m_ctrl[index] = h & 0x7f;
+        m_growthLeft--;
+        m_size++;
+    }
+
+    void grow() {
+        if (m_capacity == 0) {
+            this->rehash(GroupSize * 2);
+        } else if (m_size <= maxLoad(m_capacity) / 2) {
+            // mostly tombstones, clean them up without growing
+            this->rehash(m_capacity);
+        } else {
+            this->rehash(m_capacity * 2);
+        }
+    }
+
+    void rehash(size_t capacity) {
+        uint8_t* oldCtrl = m_ctrl;
+        Slot* oldSlots = m_slots;
+        size_t oldCapacity = m_capacity;
+
+        m_slots = std::allocator<Slot>{}.allocate(capacity);
+        m_ctrl = new uint8_t[capacity];
+        memset(m_ctrl, CtrlEmpty, capacity);
+        m_capacity = capacity;
+        m_growthLeft = maxLoad(capacity) - m_size;
+
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if ((oldCtrl[i] & 0x80) == 0) {
+                uint64_t h = this->hashOf(KeyOf::get(oldSlots[i]));
+                size_t index = this->findInsertSlot(h);
+
+                std::construct_at(m_slots + index, std::move(oldSlots[i]));
+                std::destroy_at(oldSlots + i);
+                m_ctrl[index] = h & 0x7f;
+            }
+        }
+
+        this->deallocate(oldCtrl, oldSlots, oldCapacity);
+    }
+
+    void destroyAll() {
+        if constexpr (!std::is_trivially_destructible_v<Slot>) {
+            for (size_t i = 0; i < m_capacity; i++) {
+                if (this->isFull(i)) {
+                    std::destroy_at(m_slots + i);
+                }
+            }
+        }
+    }
+
+    static void deallocate(uint8_t* ctrl, Slot* slots, size_t capacity) {
+        if (capacity > 0) {
+            delete[] ctrl;
+            std::allocator<Slot>{}.deallocate(slots, capacity);
+        }
+    }
+};
+
+// Forward iterator over the full slots of a table
+template <typename Table, typename Value>
+class FlatTableIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::remove_const_t<Value>;
+    using difference_type = ptrdiff_t;
+    using pointer = Value*;
+    using reference = Value&;
+
+    FlatTableIterator() = default;
+    FlatTableIterator(const Table* table, size_t index) : m_table(table), m_index(index) {
+        this->skipFree();
+    }
+
+    // iterator -> const_iterator conversion
+    template <typename V> requires (std::is_const_v<Value> && !std::is_const_v<V>)
+    FlatTableIterator(const FlatTableIterator<Table, V>& other) : m_table(other.m_table), m_index(other.m_index) {}
+
+    reference operator*() const {
+        return *m_table->slotAt(m_index);
+    }
+
+    pointer operator->() const {
+        return m_table->slotAt(m_index);
+    }
+
+    FlatTableIterator& operator++() {
+        m_index++;
+        this->skipFree();
+        return *this;
+    }
+
+    FlatTableIterator operator++(int) {
+        auto copy = *this;
+        ++*this;
+        return copy;
+    }
+
+    bool operator==(const FlatTableIterator& other) const {
+        return m_index == other.m_index;
+    }
+
+    size_t index() const {
+        return m_index;
+    }
+
+private:
+    template <typename, typename> friend class FlatTableIterator;
+
+    const Table* m_table = nullptr;
+    size_t m_index = 0;
+
+    void skipFree() {
+        while (m_index < m_table->capacity() && !m_table->isFull(m_index)) {
+            m_index++;
+        }
+    }
+};
+
+template <typename K, typename V>
+struct MapKeyOf {
+    static const K& get(const std::pair<const K, V>& slot) {
+        return slot.first;
+    }
+};
+
+template <typename K>
+struct SetKeyOf {
+    static const K& get(const K& slot) {
+        return slot;
+    }
+};
+
+} // namespace detail
+
+// Hash map from addresses (or any other cheaply comparable keys) to values.
+// The interface follows std::unordered_map for the most common operations.
+template <typename K, typename V, typename Hash = std::hash<K>, typename Eq = std::equal_to<K>>
+class AddressMap {
+    using Table = detail::FlatTable<std::pair<const K, V>, K, detail::MapKeyOf<K, V>, Hash, Eq>;
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<const K, V>;
+    using iterator = detail::FlatTableIterator<Table, value_type>;
+    using const_iterator = detail::FlatTableIterator<Table, const value_type>;
+
+    AddressMap() = default;
+
+    iterator begin() {
+        return iterator(&m_table, 0);
+    }
+
+    iterator end() {
+        return iterator(&m_table, m_table.capacity());
+    }
+
+    const_iterator begin() const {
+        return const_iterator(&m_table, 0);
+    }
+
+    const_iterator end() const {
+        return const_iterator(&m_table, m_table.capacity());
+    }
+
+    size_t size() const {
+        return m_table.size();
+    }
+
+    bool empty() const {
+        return m_table.size() == 0;
+    }
+
+    // Amount of slots currently allocated
+    size_t capacity() const {
+        return m_table.capacity();
+    }
+
+    void reserve(size_t count) {
+        m_table.reserve(count);
+    }
+
+    // Removes all entries, keeping the allocated memory
+    void clear() {
+        m_table.clear();
+    }
+
+    iterator find(const K& key) {
+        size_t index = m_table.findIndex(key);
+        return index == Table::npos ? this->end() : iterator(&m_table, index);
+    }
+
+    const_iterator find(const K& key) const {
+        size_t index = m_table.findIndex(key);
+        return index == Table::npos ? this->end() : const_iterator(&m_table, index);
+    }
+
+    // Returns a pointer to the value for `key`, or null if there is none
+    V* get(const K& key) {
+        size_t index = m_table.findIndex(key);
+        return index == Table::npos ? nullptr : &m_table.slotAt(index)->second;
+    }
+
+    const V* get(const K& key) const {
+        size_t index = m_table.findIndex(key);
+        return index == Table::npos ? nullptr : &m_table.slotAt(index)->second;
+    }
+
+    bool contains(const K& key) const {
+        return m_table.findIndex(key) != Table::npos;
+    }
+
+    // Inserts a value constructed from `args` if `key` is not in the map yet.
+    // Returns the entry for `key` and whether it was inserted.
+    template <typename... Args>
+    std::pair<iterator, bool> tryEmplace(const K& key, Args&&... args) {
+        auto [index, inserted] = m_table.findOrInsert(key, [&](value_type* slot) {
+            std::construct_at(slot, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+        });
+
+        return {iterator(&m_table, index), inserted};
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value) {
+        return this->tryEmplace(value.first, value.second);
+    }
+
+    std::pair<iterator, bool> insert(const K& key, V value) {
+        return this->tryEmplace(key, std::move(value));
+    }
+
+    // Inserts the value, or replaces the existing one
+    std::pair<iterator, bool> insertOrAssign(const K& key, V value) {
+        auto res = this->tryEmplace(key, std::move(value));
+        if (!res.second) {
+            res.first->second = std::move(value);
+        }
+
+        return res;
+    }
+
+    // Returns the value for `key`, inserting a default constructed one if there is none
+    V& operator[](const K& key) {
+        return this->tryEmplace(key).first->second;
+    }
+
+    // Returns whether an entry was removed
+    bool erase(const K& key) {
+        size_t index = m_table.findIndex(key);
+        if (index == Table::npos) {
+            return false;
+        }
+
+        m_table.eraseAt(index);
+        return true;
+    }
+
+    // Removes the entry, other iterators stay valid
+    void erase(const_iterator it) {
+        m_table.eraseAt(it.index());
+    }
+
+    void swap(AddressMap& other) noexcept {
+        m_table.swap(other.m_table);
+    }
+
+private:
+    Table m_table;
+};
+
+// Hash set of addresses, see AddressMap
+template <typename K, typename Hash = std::hash<K>, typename Eq = std::equal_to<K>>
+class AddressSet {
+    using Table = detail::FlatTable<K, K, detail::SetKeyOf<K>, Hash, Eq>;
+
+public:
+    using key_type = K;
+    using value_type = K;
+    using iterator = detail::FlatTableIterator<Table, const K>;
+    using const_iterator = iterator;
+
+    AddressSet() = default;
+
+    iterator begin() const {
+        return iterator(&m_table, 0);
+    }
+
+    iterator end() const {
+        return iterator(&m_table, m_table.capacity());
+    }
+
+    size_t size() const {
+        return m_table.size();
+    }
+
+    bool empty() const {
+        return m_table.size() == 0;
+    }
+
+    size_t capacity() const {
+        return m_table.capacity();
+    }
+
+    void reserve(size_t count) {
+        m_table.reserve(count);
+    }
+
+    void clear() {
+        m_table.clear();
+    }
+
+    bool contains(const K& key) const {
+        return m_table.findIndex(key) != Table::npos;
+    }
+
+    iterator find(const K& key) const {
+        size_t index = m_table.findIndex(key);
+        return index == Table::npos ? this->end() : iterator(&m_table, index);
+    }
+
+    // Returns whether the key was inserted (false if it was already in the set)
+    bool insert(const K& key) {
+        return m_table.findOrInsert(key, [&](K* slot) {
+            std::construct_at(slot, key);
+        }).second;
+    }
+
+    // Returns whether the key was removed
+    bool erase(const K& key) {
+        size_t index = m_table.findIndex(key);
+        if (index == Table::npos) {
+            return false;
+        }
+
+        m_table.eraseAt(index);
+        return true;
+    }
+
+    void erase(const_iterator it) {
+        m_table.eraseAt(it.index());
+    }
+
+    void swap(AddressSet& other) noexcept {
+        m_table.swap(other.m_table);
+    }
+
+private:
+    Table m_table;
+};
+
+} // namespace qsox
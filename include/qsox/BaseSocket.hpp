@@ -1,16 +1,55 @@
 #pragma once
 
 #include <stdint.h>
+#include <chrono>
 #include "SocketAddress.hpp"
 
 namespace qsox {
 
+class SocketFilter;
+
 #ifdef _WIN32
     using SockFd = uintptr_t; // SOCKET is a UINT_PTR on windows which is pointer sized unsigned integer
 #else
     using SockFd = int;
 #endif
 
+// Which timestamps the kernel should generate, see `BaseSocket::enableTimestamping`
+struct TimestampingOptions {
+    // Timestamp received packets, reported by the receive calls that take a `PacketTimestamp`
+    bool receive = true;
+    // Timestamp sent packets, reported through `BaseSocket::readTxTimestamps`
+    bool transmit = false;
+    // Also request hardware (NIC) timestamps. These only appear if hardware timestamping
+    // is enabled on the interface itself (SIOCSHWTSTAMP, e.g. with `hwstamp_ctl`).
+    bool hardware = false;
+};
+
+// Time a packet was received or sent, as nanoseconds since the Unix epoch (CLOCK_REALTIME).
+// Either value is zero if it is not available.
+struct PacketTimestamp {
+    std::chrono::nanoseconds software{0};
+    std::chrono::nanoseconds hardware{0};
+
+    bool valid() const {
+        return software.count() != 0 || hardware.count() != 0;
+    }
+
+    // Returns the hardware timestamp if there is one, as it excludes the kernel stack, otherwise the software one
+    std::chrono::nanoseconds best() const {
+        return hardware.count() != 0 ? hardware : software;
+    }
+};
+
+// Transmit timestamp read from the socket error queue
+struct TxTimestamp {
+    // Identifies the send the timestamp belongs to. For UDP it is the index of the datagram, counting every datagram
+    // sent since timestamping was enabled (starting at 0). For TCP it is the offset of the last byte of the send
+    // in the stream, counting from when timestamping was enabled.
+    uint32_t id = 0;
+    PacketTimestamp timestamp;
+};
+
 // Base socket class. Applications should not use this.
 class BaseSocket {
 public:
@@ -37,6 +76,43 @@ public:
 
     Error getSocketError() const;
 
+    // Sets the size of the kernel receive buffer (SO_RCVBUF). If the system limit caps the buffer below the requested
+    // size, SO_RCVBUFFORCE is tried as well, which bypasses the limit on Linux for privileged (CAP_NET_ADMIN) processes.
+    NetResult<> setReceiveBufferSize(size_t size);
+
+    // Returns the size of the kernel receive buffer. Note that Linux reports double the size that was set,
+    // as it reserves half of the buffer for bookkeeping.
+    NetResult<size_t> receiveBufferSize() const;
+
+    // Same as `setReceiveBufferSize`, for the send buffer (SO_SNDBUF, SO_SNDBUFFORCE)
+    NetResult<> setSendBufferSize(size_t size);
+
+    NetResult<size_t> sendBufferSize() const;
+
+    // Limits the rate the kernel sends at, in bytes per second (SO_MAX_PACING_RATE), 0 removes the limit.
+    // For UDP this needs the fq qdisc on the outgoing interface, TCP is paced by the kernel itself.
+    // Only supported on Linux, fails with `Unimplemented` on other platforms.
+    NetResult<> setMaxPacingRate(uint64_t bytesPerSecond);
+
+    // Attaches a classic BPF filter to the socket, replacing the previously attached one (if any).
+    // Packets rejected by the filter are dropped by the kernel and are never received.
+    // Only supported on Linux, fails with `Unimplemented` on other platforms.
+    NetResult<> attachFilter(const SocketFilter& filter);
+
+    // Removes the filter attached with `attachFilter`
+    NetResult<> detachFilter();
+
+    // Enables kernel (and optionally hardware) timestamping of packets with SO_TIMESTAMPING.
+    // Passing options with everything disabled turns timestamping off.
+    // Only supported on Linux, fails with `Unimplemented` on other platforms.
+    NetResult<> enableTimestamping(const TimestampingOptions& options = {});
+
+    // Reads transmit timestamps that are ready from the error queue, without blocking.
+    // Returns the amount of timestamps written to `out`, which is 0 if there are none yet.
+    // Fails with `MessageTooLong` if an entry's control data was truncated (that entry is lost).
+    // Only supported on Linux, fails with `Unimplemented` on other platforms.
+    NetResult<size_t> readTxTimestamps(TxTimestamp* out, size_t maxCount);
+
     inline SockFd handle() const {
         return m_fd;
     }
@@ -52,6 +128,8 @@ protected:
     BaseSocket& operator=(BaseSocket&& other) noexcept;
 
     NetResult<> _setTimeout(int kind, uint32_t timeoutMs);
+    NetResult<> _setBufferSize(int kind, int forceKind, size_t size);
+    NetResult<size_t> _getBufferSize(int kind) const;
 };
 
 enum class ShutdownMode {
@@ -0,0 +1,91 @@
+#pragma once
+
+// Caching DNS resolver with refresh-ahead of frequently used hostnames
+
+#include "Resolver.hpp"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace qsox {
+class BackgroundWorker;
+}
+
+namespace qsox::resolver {
+
+struct CacheOptions {
+    // How long a resolved address is considered fresh.
+    std::chrono::milliseconds ttl{60000};
+
+    // Fraction of the TTL after which a hot entry is refreshed in the background.
+    float refreshAhead = 0.8f;
+
+    // How long after expiry a stale entry may still be returned while it is being refreshed.
+    // Once this window passes, the lookup is performed synchronously again.
+    std::chrono::milliseconds maxStale{10000};
+
+    // Amount of lookups within a single TTL period after which an entry is considered hot.
+    uint32_t hotThreshold = 2;
+
+    // Maximum amount of cached hostnames (per address family).
+    size_t maxEntries = 4096;
+
+    // Timeout passed to the underlying resolver functions.
+    int timeoutMs = 0;
+};
+
+// A thread-safe resolver that caches successful lookups for a fixed TTL.
+// Hostnames that are looked up often are refreshed on a background thread before they expire,
+// and an expired entry is still served (for at most `maxStale`) while its refresh is in progress,
+// so that hot hostnames practically never wait on a DNS query.
+class CachingResolver {
+public:
+    CachingResolver(CacheOptions options = {});
+    ~CachingResolver();
+
+    CachingResolver(const CachingResolver&) = delete;
+    CachingResolver& operator=(const CachingResolver&) = delete;
+
+    // Returns a process-wide resolver instance with default options
+    static CachingResolver& global();
+
+    Result<Ipv4Address> resolveIpv4(const std::string& hostname);
+    Result<Ipv6Address> resolveIpv6(const std::string& hostname);
+    // Prefers IPv4 addresses, same as `resolver::resolve`
+    Result<IpAddress> resolve(const std::string& hostname);
+
+    // Removes all cached entries
+    void clear();
+
+    const CacheOptions& options() const {
+        return m_options;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Family : uint8_t {
+        Any, V4, V6
+    };
+
+    struct Entry {
+        IpAddress address;
+        Clock::time_point resolvedAt;
+        uint32_t hits;
+        bool refreshing;
+    };
+
+    CacheOptions m_options;
+    std::mutex m_mutex;
+    std::unordered_map<std::string, Entry> m_entries[3];
+    std::unique_ptr<BackgroundWorker> m_worker;
+
+    Result<IpAddress> lookup(const std::string& hostname, Family family);
+    Result<IpAddress> resolveUncached(const std::string& hostname, Family family);
+    void store(const std::string& hostname, Family family, const IpAddress& address);
+    void scheduleRefresh(const std::string& hostname, Family family, Entry& entry);
+};
+
+} // namespace qsox::resolver
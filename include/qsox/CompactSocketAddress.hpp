@@ -0,0 +1,141 @@
+#pragma once
+
+#include "SocketAddress.hpp"
+#include <compare>
+#include <optional>
+#include <type_traits>
+#include <string.h>
+
+namespace qsox {
+
+// Packed, trivially copyable representation of a SocketAddress, for storing large amounts of addresses
+// (session tables, peer lists) and using them as keys.
+//
+// Layout (20 bytes, no padding):
+//   [0]       family tag, 4 or 6
+//   [1]       always zero
+//   [2..18)   address, IPv4 addresses use the first 4 bytes and the rest is zero
+//   [18..20)  port, big-endian
+//
+// The bytes fully determine the address, so equality and hashing work on the raw bytes without branching,
+// and comparing the bytes with memcmp orders addresses by family, then address, then port.
+class CompactSocketAddress {
+public:
+    static constexpr size_t Size = 20;
+
+    // Maximum length of the string representation
+    static constexpr size_t MaxStringLength = SocketAddress::MaxStringLength;
+
+    constexpr CompactSocketAddress() : CompactSocketAddress(SocketAddressV4{}) {}
+
+    constexpr CompactSocketAddress(const SocketAddressV4& addr) : m_bytes{} {
+        m_bytes[0] = 4;
+        auto& octets = addr.address().octets();
+        for (size_t i = 0; i < 4; i++) {
+            m_bytes[2 + i] = octets[i];
+        }
+
+        this->setPort(addr.port());
+    }
+
+    constexpr CompactSocketAddress(const SocketAddressV6& addr) : m_bytes{} {
+        m_bytes[0] = 6;
+        auto& octets = addr.address().octets();
+        for (size_t i = 0; i < 16; i++) {
+            m_bytes[2 + i] = octets[i];
+        }
+
+        this->setPort(addr.port());
+    }
+
+    constexpr CompactSocketAddress(const SocketAddress& addr)
+        : CompactSocketAddress(addr.isV4() ? CompactSocketAddress(addr.toV4()) : CompactSocketAddress(addr.toV6())) {}
+
+    // Uses `Size` raw bytes in the layout described above, returns nullopt if they don't form a valid address
+    static std::optional<CompactSocketAddress> fromBytes(const uint8_t* bytes);
+
+    static CompactSocketAddress fromSockAddr(const sockaddr& addr);
+
+    // Comparison works on the raw bytes
+
+    bool operator==(const CompactSocketAddress& other) const {
+        return memcmp(m_bytes, other.m_bytes, Size) == 0;
+    }
+
+    std::strong_ordering operator<=>(const CompactSocketAddress& other) const {
+        return memcmp(m_bytes, other.m_bytes, Size) <=> 0;
+    }
+
+    constexpr bool isV4() const {
+        return m_bytes[0] == 4;
+    }
+
+    constexpr bool isV6() const {
+        return m_bytes[0] == 6;
+    }
+
+    constexpr uint16_t port() const {
+        return static_cast<uint16_t>(m_bytes[18] << 8 | m_bytes[19]);
+    }
+
+    constexpr void setPort(uint16_t port) {
+        m_bytes[18] = static_cast<uint8_t>(port >> 8);
+        m_bytes[19] = static_cast<uint8_t>(port);
+    }
+
+    constexpr IpAddress address() const {
+        if (this->isV4()) {
+            return Ipv4Address{m_bytes[2], m_bytes[3], m_bytes[4], m_bytes[5]};
+        }
+
+        std::array<uint8_t, 16> octets{};
+        for (size_t i = 0; i < 16; i++) {
+            octets[i] = m_bytes[2 + i];
+        }
+
+        return Ipv6Address{octets};
+    }
+
+    constexpr SocketAddress toSocketAddress() const {
+        return SocketAddress{this->address(), this->port()};
+    }
+
+    // Returns the raw bytes, `Size` bytes long
+    constexpr const uint8_t* data() const {
+        return m_bytes;
+    }
+
+    // Returns the address family (AF_INET or AF_INET6)
+    int family() const;
+
+    std::string toString() const;
+    // Writes the string representation into `buf`, which must hold at least `MaxStringLength` characters.
+    // Returns the pointer past the last written character, no null terminator is written.
+    char* toChars(char* buf) const;
+
+private:
+    uint8_t m_bytes[Size];
+};
+
+static_assert(sizeof(CompactSocketAddress) == CompactSocketAddress::Size);
+static_assert(std::is_trivially_copyable_v<CompactSocketAddress>);
+
+} // namespace qsox
+
+// hash
+namespace std {
+
+template <>
+struct hash<qsox::CompactSocketAddress> {
+    size_t operator()(const qsox::CompactSocketAddress& addr) const {
+        uint64_t a, b;
+        uint32_t c;
+        memcpy(&a, addr.data(), 8);
+        memcpy(&b, addr.data() + 8, 8);
+        memcpy(&c, addr.data() + 16, 4);
+
+        return static_cast<size_t>(qsox::hash::hashWords(a ^ (static_cast<uint64_t>(c) * qsox::hash::Secret2), b, 20));
+    }
+};
+
+} // namespace std
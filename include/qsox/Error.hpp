@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Geode/Result.hpp>
+#include <stdint.h>
 
 namespace qsox {
     class Error {
@@ -32,12 +33,17 @@ namespace qsox {
         constexpr inline Error(Code code, int osCode = 0) : m_code(code), m_osCode(osCode) {}
 
         static Error fromOs(int osCode);
+        // `MessageTooLong` error carrying the path MTU that was known when sending failed
+        static Error messageTooLong(uint32_t mtu);
         // `net` - whether to use WSAGetLastError()
         static Error lastOsError(bool net = true);
 
         Code code() const;
         bool isOsError() const;
         int osCode() const;
+        // For `MessageTooLong` errors from sends on UDP sockets, the path MTU (including IP and UDP headers)
+        // that the datagram exceeded, or 0 if it isn't known
+        uint32_t mtu() const;
 
         bool operator==(const Error& other) const;
         bool operator!=(const Error& other) const;
@@ -49,6 +55,7 @@ namespace qsox {
     protected:
         Code m_code;
         int m_osCode = 0;
+        uint32_t m_mtu = 0;
 
         static std::string osMessage(int osCode);
     };
@@ -73,6 +80,12 @@ namespace qsox {
     }
 
     [[noreturn]] void unreachable();
+
+    namespace detail {
+        // Deliberately not constexpr, calling this from a consteval function (e.g. an address literal)
+        // makes the evaluation fail, which turns a malformed literal into a compile error.
+        inline void invalidLiteral(const char*) {}
+    }
 }
 
 #define QSOX_MAKE_ERROR_STRUCT(name, ...) \
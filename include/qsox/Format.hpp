@@ -0,0 +1,59 @@
+#pragma once
+
+// fmt::formatter specializations for the address types, so they can be passed to fmt::format directly
+// without going through toString(). Formatting writes into a stack buffer and does not allocate.
+// Standard string format specs (width, fill, alignment) are supported, e.g. fmt::format("{:>21}", addr).
+//
+// This header is opt-in, qsox itself links fmt privately, so including it requires fmt to be available to the consumer.
+
+#include "CompactSocketAddress.hpp"
+#include "NetworkAddress.hpp"
+#include <fmt/format.h>
+
+namespace qsox::detail {
+
+template <typename T>
+struct AddressFormatter : fmt::formatter<fmt::string_view> {
+    template <typename FormatContext>
+    auto format(const T& value, FormatContext& ctx) const {
+        char buf[T::MaxStringLength];
+        char* end = value.toChars(buf);
+        return fmt::formatter<fmt::string_view>::format(fmt::string_view(buf, end - buf), ctx);
+    }
+};
+
+} // namespace qsox::detail
+
+template <>
+struct fmt::formatter<qsox::Ipv4Address> : qsox::detail::AddressFormatter<qsox::Ipv4Address> {};
+
+template <>
+struct fmt::formatter<qsox::Ipv6Address> : qsox::detail::AddressFormatter<qsox::Ipv6Address> {};
+
+template <>
+struct fmt::formatter<qsox::IpAddress> : qsox::detail::AddressFormatter<qsox::IpAddress> {};
+
+template <>
+struct fmt::formatter<qsox::SocketAddressV4> : qsox::detail::AddressFormatter<qsox::SocketAddressV4> {};
+
+template <>
+struct fmt::formatter<qsox::SocketAddressV6> : qsox::detail::AddressFormatter<qsox::SocketAddressV6> {};
+
+template <>
+struct fmt::formatter<qsox::SocketAddress> : qsox::detail::AddressFormatter<qsox::SocketAddress> {};
+
+template <>
+struct fmt::formatter<qsox::CompactSocketAddress> : qsox::detail::AddressFormatter<qsox::CompactSocketAddress> {};
+
+template <>
+struct fmt::formatter<qsox::NetworkAddress> : fmt::formatter<fmt::string_view> {
+    template <typename FormatContext>
+    auto format(const qsox::NetworkAddress& value, FormatContext& ctx) const {
+        // the host has no length limit, the inline storage of memory_buffer covers any sane hostname
+        fmt::memory_buffer buf;
+        buf.append(fmt::string_view(value.host()));
+        buf.push_back(':');
+        fmt::format_to(std::back_inserter(buf), "{}", value.port());
+        return fmt::formatter<fmt::string_view>::format(fmt::string_view(buf.data(), buf.size()), ctx);
+    }
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+// Fast, high quality hashing of fixed size keys (addresses and ports), in the style of wyhash/rapidhash.
+// Every input goes through a full 64x64->128 bit multiply, so nearby addresses and ports
+// (e.g. 10.0.0.1:5000 and 10.0.0.2:5001) end up spread across all bits of the result.
+// Hashes are not stable across versions and must not be persisted.
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+# include <intrin.h>
+#endif
+
+namespace qsox::hash {
+
+constexpr uint64_t Secret0 = 0xa0761d6478bd642full;
+constexpr uint64_t Secret1 = 0xe7037ed1a0b428dbull;
+constexpr uint64_t Secret2 = 0x8ebc6af09c88c6e3ull;
+
+// Multiplies two 64-bit values into a 128-bit result, and folds it back into 64 bits
+inline uint64_t mum(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = static_cast<__uint128_t>(a) * b;
+    return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    uint64_t hi;
+    uint64_t lo = _umul128(a, b, &hi);
+    return lo ^ hi;
+#else
+    uint64_t aLo = a & 0xffffffff, aHi = a >> 32;
+    uint64_t bLo = b & 0xffffffff, bHi = b >> 32;
+    uint64_t ll = aLo * bLo, lh = aLo * bHi, hl = aHi * bLo, hh = aHi * bHi;
+    uint64_t mid = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+    uint64_t lo = (ll & 0xffffffff) | (mid << 32);
+    uint64_t hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    return lo ^ hi;
+#endif
+}
+
+// Hashes up to 16 bytes of input, given as two words. `len` is mixed in so that keys of different sizes don't collide.
+inline uint64_t hashWords(uint64_t a, uint64_t b, uint64_t len) {
+    return mum(mum(a ^ Secret1, b ^ Secret0) ^ Secret0 ^ len, Secret1 ^ len);
+}
+
+// Combines an existing hash with another value
+inline uint64_t combine(uint64_t hash, uint64_t value) {
+    return mum(hash ^ Secret2, value ^ Secret1);
+}
+
+// IPv4 address (4 bytes)
+inline uint64_t hashIpv4(uint32_t bits) {
+    return hashWords(bits, 0, 4);
+}
+
+// IPv4 address + port (6 bytes)
+inline uint64_t hashIpv4(uint32_t bits, uint16_t port) {
+    return hashWords(static_cast<uint64_t>(bits) << 16 | port, 0, 6);
+}
+
+// IPv6 address (16 bytes)
+inline uint64_t hashIpv6(const uint8_t* octets) {
+    uint64_t a, b;
+    memcpy(&a, octets, 8);
+    memcpy(&b, octets + 8, 8);
+    return hashWords(a, b, 16);
+}
+
+// IPv6 address + port (18 bytes)
+inline uint64_t hashIpv6(const uint8_t* octets, uint16_t port) {
+    uint64_t a, b;
+    memcpy(&a, octets, 8);
+    memcpy(&b, octets + 8, 8);
+
+    // the port goes into the first word, which is then fully mixed with the second one
+    return hashWords(a ^ (static_cast<uint64_t>(port) * Secret2), b, 18);
+}
+
+} // namespace qsox::hash
@@ -67,8 +67,25 @@ public:
 
     // Common methods
 
+    // Maximum length of the string representation
+    static constexpr size_t MaxStringLength = Ipv6Address::MaxStringLength;
+
     std::string toString() const;
-    static Result<IpAddress, void> parse(const std::string& str);
+    // Writes the string representation into `buf`, which must hold at least `MaxStringLength` characters.
+    // Returns the pointer past the last written character, no null terminator is written.
+    char* toChars(char* buf) const;
+    static Result<IpAddress, void> parse(std::string_view str);
+
+    // Same as `parse`, but usable in constant expressions, see also the `_ip` literal.
+    static constexpr std::optional<IpAddress> parseConstexpr(std::string_view str) {
+        if (auto v4 = Ipv4Address::parseConstexpr(str)) {
+            return IpAddress(*v4);
+        } else if (auto v6 = Ipv6Address::parseConstexpr(str)) {
+            return IpAddress(*v6);
+        }
+
+        return std::nullopt;
+    }
 
     constexpr bool isLocalhost() const {
         return this->isV4() ? this->asV4().isLocalhost() : this->asV6().isLocalhost();
@@ -83,6 +100,21 @@ private:
     friend struct std::hash<qsox::IpAddress>;
 };
 
+// Address literals, e.g. `constexpr auto addr = "10.0.0.1"_ip;`
+// Parsing happens at compile time, and a malformed literal is a compile error.
+inline namespace literals {
+
+consteval IpAddress operator""_ip(const char* str, size_t len) {
+    auto addr = IpAddress::parseConstexpr(std::string_view{str, len});
+    if (!addr) {
+        detail::invalidLiteral("invalid IP address literal");
+    }
+
+    return *addr;
+}
+
+} // namespace literals
+
 } // namespace qsox
 
 // hash
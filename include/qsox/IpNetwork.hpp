@@ -0,0 +1,309 @@
+#pragma once
+
+#include "Error.hpp"
+#include "IpAddress.hpp"
+
+namespace qsox {
+
+QSOX_MAKE_ERROR_STRUCT(IpNetworkParseError,
+    InvalidAddress,
+    MissingPrefix,
+    InvalidPrefix,
+);
+
+// An IPv4 network in CIDR notation, e.g. 10.0.0.0/8.
+// The host bits of the address are always cleared, so 10.1.2.3/8 is the same network as 10.0.0.0/8.
+class Ipv4Network {
+public:
+    static constexpr uint8_t MaxPrefixLength = 32;
+
+    // Maximum length of the string representation ('255.255.255.255/32')
+    static constexpr size_t MaxStringLength = Ipv4Address::MaxStringLength + 3;
+
+    // Represents 0.0.0.0/0
+    constexpr Ipv4Network() : m_address(), m_prefix(0) {}
+
+    // Prefix lengths above 32 are clamped to 32.
+    constexpr Ipv4Network(const Ipv4Address& address, uint8_t prefix)
+        : m_prefix(prefix > MaxPrefixLength ? MaxPrefixLength : prefix)
+    {
+        m_address = Ipv4Address::fromBits(address.toBits() & maskBits(m_prefix));
+    }
+
+    constexpr Ipv4Network(const Ipv4Network& other) = default;
+    constexpr Ipv4Network& operator=(const Ipv4Network& other) = default;
+
+    constexpr bool operator==(const Ipv4Network& other) const {
+        return m_address == other.m_address && m_prefix == other.m_prefix;
+    }
+
+    constexpr bool operator!=(const Ipv4Network& other) const {
+        return !(*this == other);
+    }
+
+    // Returns the network address (first address in the network)
+    constexpr const Ipv4Address& address() const {
+        return m_address;
+    }
+
+    constexpr uint8_t prefixLength() const {
+        return m_prefix;
+    }
+
+    // Returns the netmask, e.g. 255.255.255.0 for a /24
+    constexpr Ipv4Address netmask() const {
+        return Ipv4Address::fromBits(maskBits(m_prefix));
+    }
+
+    // Returns the broadcast address (last address in the network)
+    constexpr Ipv4Address broadcast() const {
+        return Ipv4Address::fromBits(m_address.toBits() | ~maskBits(m_prefix));
+    }
+
+    constexpr bool contains(const Ipv4Address& addr) const {
+        return (addr.toBits() & maskBits(m_prefix)) == m_address.toBits();
+    }
+
+    // Returns whether `other` is fully contained within this network
+    constexpr bool contains(const Ipv4Network& other) const {
+        return other.m_prefix >= m_prefix && this->contains(other.m_address);
+    }
+
+    // Parses a network in the form of 'a.b.c.d/n'
+    static Result<Ipv4Network, IpNetworkParseError> parse(std::string_view str);
+
+    std::string toString() const;
+    // Writes the string representation into `buf`, which must hold at least `MaxStringLength` characters.
+    // Returns the pointer past the last written character, no null terminator is written.
+    char* toChars(char* buf) const;
+
+private:
+    Ipv4Address m_address;
+    uint8_t m_prefix;
+
+    static constexpr uint32_t maskBits(uint8_t prefix) {
+        return prefix == 0 ? 0 : ~uint32_t(0) << (32 - prefix);
+    }
+};
+
+// An IPv6 network in CIDR notation, e.g. 2001:db8::/32.
+// The host bits of the address are always cleared, so 2001:db8::1/32 is the same network as 2001:db8::/32.
+class Ipv6Network {
+public:
+    static constexpr uint8_t MaxPrefixLength = 128;
+
+    // Maximum length of the string representation (address + '/128')
+    static constexpr size_t MaxStringLength = Ipv6Address::MaxStringLength + 4;
+
+    // Represents ::/0
+    constexpr Ipv6Network() : m_address(), m_prefix(0) {}
+
+    // Prefix lengths above 128 are clamped to 128.
+    constexpr Ipv6Network(const Ipv6Address& address, uint8_t prefix)
+        : m_address(address), m_prefix(prefix > MaxPrefixLength ? MaxPrefixLength : prefix)
+    {
+        auto& octets = m_address.octets();
+
+        for (size_t i = 0; i < 16; i++) {
+            octets[i] &= maskOctet(m_prefix, i);
+        }
+    }
+
+    constexpr Ipv6Network(const Ipv6Network& other) = default;
+    constexpr Ipv6Network& operator=(const Ipv6Network& other) = default;
+
+    constexpr bool operator==(const Ipv6Network& other) const {
+        return m_address == other.m_address && m_prefix == other.m_prefix;
+    }
+
+    constexpr bool operator!=(const Ipv6Network& other) const {
+        return !(*this == other);
+    }
+
+    // Returns the network address (first address in the network)
+    constexpr const Ipv6Address& address() const {
+        return m_address;
+    }
+
+    constexpr uint8_t prefixLength() const {
+        return m_prefix;
+    }
+
+    // Returns the netmask, e.g. ffff:ffff:ffff:ffff:: for a /64
+    constexpr Ipv6Address netmask() const {
+        std::array<uint8_t, 16> octets{};
+
+        for (size_t i = 0; i < 16; i++) {
+            octets[i] = maskOctet(m_prefix, i);
+        }
+
+        return Ipv6Address(octets);
+    }
+
+    // Returns the last address in the network
+    constexpr Ipv6Address last() const {
+        auto octets = m_address.octets();
+
+        for (size_t i = 0; i < 16; i++) {
+            octets[i] |= static_cast<uint8_t>(~maskOctet(m_prefix, i));
+        }
+
+        return Ipv6Address(octets);
+    }
+
+    constexpr bool contains(const Ipv6Address& addr) const {
+        auto& ours = m_address.octets();
+        auto& theirs = addr.octets();
+
+        for (size_t i = 0; i < 16; i++) {
+            if ((theirs[i] & maskOctet(m_prefix, i)) != ours[i]) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Returns whether `other` is fully contained within this network
+    constexpr bool contains(const Ipv6Network& other) const {
+        return other.m_prefix >= m_prefix && this->contains(other.m_address);
+    }
+
+    // Parses a network in the form of 'addr/n'
+    static Result<Ipv6Network, IpNetworkParseError> parse(std::string_view str);
+
+    std::string toString() const;
+    // Writes the string representation into `buf`, which must hold at least `MaxStringLength` characters.
+    // Returns the pointer past the last written character, no null terminator is written.
+    char* toChars(char* buf) const;
+
+private:
+    Ipv6Address m_address;
+    uint8_t m_prefix;
+
+    // Returns the mask of the octet at `index` for the given prefix length
+    static constexpr uint8_t maskOctet(uint8_t prefix, size_t index) {
+        size_t bits = index * 8;
+
+        if (prefix >= bits + 8) {
+            return 0xff;
+        } else if (prefix <= bits) {
+            return 0;
+        }
+
+        return static_cast<uint8_t>(0xff << (8 - (prefix - bits)));
+    }
+};
+
+// Class that can hold either an IPv4 or IPv6 network.
+class IpNetwork {
+public:
+    // Maximum length of the string representation
+    static constexpr size_t MaxStringLength = Ipv6Network::MaxStringLength;
+
+    constexpr IpNetwork(const Ipv4Network& net) : m_network(net) {}
+    constexpr IpNetwork(const Ipv6Network& net) : m_network(net) {}
+
+    // Host bits of the address are cleared, and the prefix length is clamped to the maximum of the address family.
+    constexpr IpNetwork(const IpAddress& addr, uint8_t prefix)
+        : m_network(addr.isV4() ? std::variant<Ipv4Network, Ipv6Network>(Ipv4Network(addr.asV4(), prefix))
+                                : std::variant<Ipv4Network, Ipv6Network>(Ipv6Network(addr.asV6(), prefix))) {}
+
+    constexpr IpNetwork(const IpNetwork& other) = default;
+    constexpr IpNetwork& operator=(const IpNetwork& other) = default;
+
+    constexpr bool operator==(const IpNetwork& other) const {
+        return m_network == other.m_network;
+    }
+
+    constexpr bool operator!=(const IpNetwork& other) const {
+        return !(*this == other);
+    }
+
+    // Checking
+
+    constexpr bool isV4() const {
+        return std::holds_alternative<Ipv4Network>(m_network);
+    }
+
+    constexpr bool isV6() const {
+        return std::holds_alternative<Ipv6Network>(m_network);
+    }
+
+    // Getters
+
+    constexpr const Ipv4Network& asV4() const {
+        return std::get<Ipv4Network>(m_network);
+    }
+
+    constexpr const Ipv6Network& asV6() const {
+        return std::get<Ipv6Network>(m_network);
+    }
+
+    // Returns the network address (first address in the network)
+    constexpr IpAddress address() const {
+        return this->isV4() ? IpAddress(this->asV4().address()) : IpAddress(this->asV6().address());
+    }
+
+    constexpr uint8_t prefixLength() const {
+        return this->isV4() ? this->asV4().prefixLength() : this->asV6().prefixLength();
+    }
+
+    // Returns whether the address is within this network, addresses of the other family are never contained.
+    constexpr bool contains(const IpAddress& addr) const {
+        if (this->isV4()) {
+            return addr.isV4() && this->asV4().contains(addr.asV4());
+        } else {
+            return addr.isV6() && this->asV6().contains(addr.asV6());
+        }
+    }
+
+    // Returns whether `other` is fully contained within this network
+    constexpr bool contains(const IpNetwork& other) const {
+        if (this->isV4()) {
+            return other.isV4() && this->asV4().contains(other.asV4());
+        } else {
+            return other.isV6() && this->asV6().contains(other.asV6());
+        }
+    }
+
+    // Parses an IPv4 or IPv6 network in CIDR notation
+    static Result<IpNetwork, IpNetworkParseError> parse(std::string_view str);
+
+    std::string toString() const;
+    // Writes the string representation into `buf`, which must hold at least `MaxStringLength` characters.
+    // Returns the pointer past the last written character, no null terminator is written.
+    char* toChars(char* buf) const;
+
+private:
+    std::variant<Ipv4Network, Ipv6Network> m_network;
+};
+
+} // namespace qsox
+
+// hash
+namespace std {
+
+template <>
+struct hash<qsox::Ipv4Network> {
+    size_t operator()(const qsox::Ipv4Network& net) const {
+        return static_cast<size_t>(qsox::hash::hashIpv4(net.address().toBits(), net.prefixLength()));
+    }
+};
+
+template <>
+struct hash<qsox::Ipv6Network> {
+    size_t operator()(const qsox::Ipv6Network& net) const {
+        return static_cast<size_t>(qsox::hash::hashIpv6(net.address().octets().data(), net.prefixLength()));
+    }
+};
+
+template <>
+struct hash<qsox::IpNetwork> {
+    size_t operator()(const qsox::IpNetwork& net) const {
+        return net.isV4() ? std::hash<qsox::Ipv4Network>()(net.asV4())
+                          : std::hash<qsox::Ipv6Network>()(net.asV6());
+    }
+};
+
+} // namespace std
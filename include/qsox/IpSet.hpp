@@ -0,0 +1,108 @@
+#pragma once
+
+// Compiled, memory-mappable IP sets (e.g. blocklists).
+//
+// An `IpSetBuilder` collects addresses, networks and ranges, and compiles them into a compact binary file
+// of sorted, merged ranges. A `MappedIpSet` maps such a file and answers membership queries directly from the
+// mapping, so loading is instant regardless of the set size, and the memory is shared between processes.
+//
+// File layout (all integers are little-endian, all sections are 8-byte aligned):
+//   header            64 bytes, see IpSet.cpp
+//   IPv4 section      range starts (u32[n]), range ends (u32[n]), then a 65537 entry u32 index
+//                     mapping the first 16 bits of an address to the first range starting at or after it
+//   IPv6 section      range starts (u64 pairs, high half first), then range ends
+// The header contains a format version and a checksum of everything after it.
+
+#include "IpNetwork.hpp"
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace qsox {
+
+class MappedFile;
+
+QSOX_MAKE_ERROR_STRUCT(IpSetError,
+    OpenFailed,
+    WriteFailed,
+    InvalidFormat,
+    UnsupportedVersion,
+    ChecksumMismatch,
+);
+
+class IpSetBuilder {
+public:
+    void add(const Ipv4Address& addr);
+    void add(const Ipv6Address& addr);
+    void add(const IpAddress& addr);
+    void add(const IpNetwork& network);
+
+    // Adds all addresses from `first` to `last` (inclusive), does nothing if `last` comes before `first`.
+    void addRange(const Ipv4Address& first, const Ipv4Address& last);
+    void addRange(const Ipv6Address& first, const Ipv6Address& last);
+
+    // Adds entries from text, one per line: an address, a network in CIDR notation, or a 'first-last' range.
+    // Surrounding whitespace and everything after a '#' is ignored.
+    // Returns the amount of lines that could not be parsed, those are skipped.
+    size_t addText(std::string_view text);
+
+    // Returns the amount of entries added so far, before merging
+    size_t size() const;
+
+    // Sorts and merges all entries, and returns the compiled file contents
+    std::vector<uint8_t> compile() const;
+
+    // Compiles and writes the set to `path`. The file is written next to it first and then renamed over it,
+    // so processes that have the old file mapped keep seeing consistent data.
+    Result<void, IpSetError> writeFile(const std::filesystem::path& path) const;
+
+private:
+    struct Range6 {
+        uint64_t firstHi, firstLo;
+        uint64_t lastHi, lastLo;
+    };
+
+    std::vector<std::pair<uint32_t, uint32_t>> m_v4;
+    std::vector<Range6> m_v6;
+};
+
+// Read-only view of a compiled IP set. Lookups are lock-free and can be done from any amount of threads.
+class MappedIpSet {
+public:
+    // Maps a compiled file. Checksum verification reads the whole file once, it can be skipped for faster startup
+    // when the file is trusted (e.g. it was verified by whoever deployed it).
+    static Result<MappedIpSet, IpSetError> open(const std::filesystem::path& path, bool verifyChecksum = true);
+
+    // Uses compiled set data that is already in memory. The data is not copied and must outlive the set,
+    // and must be at least 8-byte aligned.
+    static Result<MappedIpSet, IpSetError> fromBuffer(const void* data, size_t size, bool verifyChecksum = true);
+
+    MappedIpSet(MappedIpSet&& other) noexcept;
+    MappedIpSet& operator=(MappedIpSet&& other) noexcept;
+    ~MappedIpSet();
+
+    bool contains(const Ipv4Address& addr) const;
+    bool contains(const Ipv6Address& addr) const;
+    bool contains(const IpAddress& addr) const;
+
+    // Amount of merged ranges in the set
+    size_t v4RangeCount() const;
+    size_t v6RangeCount() const;
+
+private:
+    std::unique_ptr<MappedFile> m_file;
+
+    const uint32_t* m_v4Starts = nullptr;
+    const uint32_t* m_v4Ends = nullptr;
+    const uint32_t* m_v4Index = nullptr;
+    size_t m_v4Count = 0;
+
+    const uint64_t* m_v6Starts = nullptr;
+    const uint64_t* m_v6Ends = nullptr;
+    size_t m_v6Count = 0;
+
+    MappedIpSet();
+};
+
+} // namespace qsox
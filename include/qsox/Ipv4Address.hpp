@@ -2,9 +2,13 @@
 
 #include <array>
 #include <compare>
+#include <optional>
+#include <string_view>
+#include <vector>
 #include <stdint.h>
 #include <stddef.h>
 #include "Error.hpp"
+#include "Hash.hpp"
 
 struct in_addr;
 
@@ -27,6 +31,9 @@ public:
     // Represents 255.255.255.255
     static const Ipv4Address BROADCAST;
 
+    // Maximum length of the string representation ('255.255.255.255')
+    static constexpr size_t MaxStringLength = 15;
+
     constexpr Ipv4Address() : Ipv4Address(0, 0, 0, 0) {}
     constexpr Ipv4Address(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : m_octets{a, b, c, d} {}
     constexpr Ipv4Address(const std::array<uint8_t, 4>& octets) : m_octets(octets) {}
@@ -83,7 +90,57 @@ public:
     }
 
     static Result<Ipv4Address, Ipv4ParseError> parse(std::string_view str);
+
+    // Same as `parse`, but usable in constant expressions, see also the `_ipv4` literal.
+    // At runtime `parse` should be preferred, as it is faster.
+    static constexpr std::optional<Ipv4Address> parseConstexpr(std::string_view str) {
+        Ipv4Address out;
+
+        for (size_t i = 0; i < 4; i++) {
+            size_t len = 0;
+            uint32_t value = 0;
+
+            while (len < str.size() && str[len] >= '0' && str[len] <= '9') {
+                value = value * 10 + static_cast<uint32_t>(str[len] - '0');
+                if (value > 255) {
+                    return std::nullopt;
+                }
+
+                len++;
+            }
+
+            if (len == 0) {
+                return std::nullopt;
+            }
+
+            out.m_octets[i] = static_cast<uint8_t>(value);
+            str.remove_prefix(len);
+
+            if (i < 3) {
+                if (str.empty() || str.front() != '.') {
+                    return std::nullopt;
+                }
+
+                str.remove_prefix(1);
+            }
+        }
+
+        if (!str.empty()) {
+            return std::nullopt;
+        }
+
+        return out;
+    }
+
+    // Parses a buffer of addresses separated by newlines and/or `delimiter` (e.g. a log file, or a CSV column),
+    // appending them to `out`. Surrounding whitespace is ignored, and so are empty entries.
+    // Entries that fail to parse are skipped, and the amount of them is returned.
+    static size_t parseMany(std::string_view input, std::vector<Ipv4Address>& out, char delimiter = '\n');
+
     std::string toString() const;
+    // Writes the string representation into `buf`, which must hold at least `MaxStringLength` characters.
+    // Returns the pointer past the last written character, no null terminator is written.
+    char* toChars(char* buf) const;
     void toInAddr(in_addr& addr) const;
     static Ipv4Address fromInAddr(const in_addr& addr);
 
@@ -111,8 +168,25 @@ public:
 
 private:
     std::array<uint8_t, 4> m_octets;
+
+    static Result<Ipv4Address, Ipv4ParseError> parseScalar(std::string_view str);
 };
 
+// Address literals, e.g. `constexpr auto addr = "10.0.0.1"_ipv4;`
+// Parsing happens at compile time, and a malformed literal is a compile error.
+inline namespace literals {
+
+consteval Ipv4Address operator""_ipv4(const char* str, size_t len) {
+    auto addr = Ipv4Address::parseConstexpr(std::string_view{str, len});
+    if (!addr) {
+        detail::invalidLiteral("invalid IPv4 address literal");
+    }
+
+    return *addr;
+}
+
+} // namespace literals
+
 }
 
 // Hash implementation
@@ -121,7 +195,7 @@ namespace std {
 template <>
 struct hash<qsox::Ipv4Address> {
     size_t operator()(const qsox::Ipv4Address& addr) const {
-        return std::hash<uint32_t>()(addr.toBits());
+        return static_cast<size_t>(qsox::hash::hashIpv4(addr.toBits()));
     }
 };
 
@@ -24,6 +24,9 @@ public:
     // Represents :: (unspecified address)
     static const Ipv6Address UNSPECIFIED;
 
+    // Maximum length of the string representation (same as INET6_ADDRSTRLEN without the null terminator)
+    static constexpr size_t MaxStringLength = 45;
+
     constexpr Ipv6Address() : m_octets{} {}
     constexpr Ipv6Address(uint8_t a, uint8_t b, uint8_t c, uint8_t d,
                                  uint8_t e, uint8_t f, uint8_t g, uint8_t h,
@@ -69,8 +72,28 @@ public:
 
     std::array<uint16_t, 8> segments() const;
 
-    static Result<Ipv6Address, Ipv6ParseError> parse(const std::string& str);
+    // Parses an IPv6 address, optionally enclosed in square brackets. Does not allocate.
+    static Result<Ipv6Address, Ipv6ParseError> parse(std::string_view str);
+
+    // Same as `parse`, but usable in constant expressions, see also the `_ipv6` literal.
+    // At runtime `parse` should be preferred, as it is faster.
+    static constexpr std::optional<Ipv6Address> parseConstexpr(std::string_view str) {
+        if (!str.empty() && str.front() == '[') {
+            if (str.size() < 2 || str.back() != ']') {
+                return std::nullopt;
+            }
+
+            str.remove_prefix(1);
+            str.remove_suffix(1);
+        }
+
+        return parseBareConstexpr(str);
+    }
+
     std::string toString() const;
+    // Writes the string representation into `buf`, which must hold at least `MaxStringLength` characters.
+    // Returns the pointer past the last written character, no null terminator is written.
+    char* toChars(char* buf) const;
     void toInAddr(in6_addr& addr) const;
     static Ipv6Address fromInAddr(const in6_addr& addr);
 
@@ -97,8 +120,141 @@ public:
 
 protected:
     std::array<uint8_t, 16> m_octets;
+
+    // Parsers that handle brackets themselves (socket addresses) or don't allow them (networks)
+    // use these, so that brackets are only ever stripped once
+    friend class SocketAddress;
+    friend class SocketAddressV6;
+    friend class Ipv6Network;
+
+    // Same as `parse`, but without accepting square brackets
+    static Result<Ipv6Address, Ipv6ParseError> parseBare(std::string_view str);
+
+    static constexpr std::optional<Ipv6Address> parseBareConstexpr(std::string_view str) {
+        if (str.size() < 2 || str.size() > 45) {
+            return std::nullopt;
+        }
+
+        auto hexValue = [](char c) -> int {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        };
+
+        constexpr size_t NoCompression = static_cast<size_t>(-1);
+
+        std::array<uint16_t, 8> groups{};
+        size_t count = 0;
+        size_t compressAt = NoCompression; // index of the group where '::' is, if any
+        size_t i = 0;
+
+        if (str[0] == ':') {
+            if (str[1] != ':') {
+                return std::nullopt;
+            }
+
+            compressAt = 0;
+            i = 2;
+        }
+
+        while (i < str.size()) {
+            size_t len = 0;
+            uint32_t group = 0;
+
+            while (i + len < str.size() && hexValue(str[i + len]) >= 0) {
+                // runs longer than 4 digits are rejected below
+                if (len < 4) {
+                    group = group << 4 | static_cast<uint32_t>(hexValue(str[i + len]));
+                }
+
+                len++;
+            }
+
+            // embedded IPv4 address, must take up the rest of the string and the last 2 groups
+            if (len > 0 && i + len < str.size() && str[i + len] == '.') {
+                auto v4 = Ipv4Address::parseConstexpr(str.substr(i));
+                if (count > 6 || !v4) {
+                    return std::nullopt;
+                }
+
+                groups[count++] = static_cast<uint16_t>((*v4)[0] << 8 | (*v4)[1]);
+                groups[count++] = static_cast<uint16_t>((*v4)[2] << 8 | (*v4)[3]);
+                break;
+            }
+
+            if (len == 0 || len > 4 || count == 8) {
+                return std::nullopt;
+            }
+
+            groups[count++] = static_cast<uint16_t>(group);
+            i += len;
+
+            if (i == str.size()) {
+                break;
+            }
+
+            if (str[i] != ':') {
+                return std::nullopt;
+            }
+
+            i++;
+
+            if (i < str.size() && str[i] == ':') {
+                if (compressAt != NoCompression) {
+                    return std::nullopt;
+                }
+
+                compressAt = count;
+                i++;
+            } else if (i == str.size()) {
+                // trailing single colon
+                return std::nullopt;
+            }
+        }
+
+        if (compressAt == NoCompression ? count != 8 : count > 7) {
+            return std::nullopt;
+        }
+
+        // expand '::' by moving the groups after it to the end
+        if (compressAt != NoCompression) {
+            size_t tail = count - compressAt;
+
+            for (size_t g = 0; g < tail; g++) {
+                groups[7 - g] = groups[count - 1 - g];
+            }
+
+            for (size_t g = compressAt; g < 8 - tail; g++) {
+                groups[g] = 0;
+            }
+        }
+
+        Ipv6Address addr;
+        for (size_t g = 0; g < 8; g++) {
+            addr.m_octets[g * 2] = static_cast<uint8_t>(groups[g] >> 8);
+            addr.m_octets[g * 2 + 1] = static_cast<uint8_t>(groups[g]);
+        }
+
+        return addr;
+    }
 };
 
+// Address literals, e.g. `constexpr auto addr = "::1"_ipv6;`
+// Parsing happens at compile time, and a malformed literal is a compile error.
+inline namespace literals {
+
+consteval Ipv6Address operator""_ipv6(const char* str, size_t len) {
+    auto addr = Ipv6Address::parseConstexpr(std::string_view{str, len});
+    if (!addr) {
+        detail::invalidLiteral("invalid IPv6 address literal");
+    }
+
+    return *addr;
+}
+
+} // namespace literals
+
 } // namespace qsox
 
 // Hash implementation
@@ -107,8 +263,7 @@ namespace std {
 template <>
 struct hash<qsox::Ipv6Address> {
     size_t operator()(const qsox::Ipv6Address& addr) const {
-        std::hash<std::string_view> hasher;
-        return hasher(std::string_view(reinterpret_cast<const char*>(addr.octets().data()), 16));
+        return static_cast<size_t>(qsox::hash::hashIpv6(addr.octets().data()));
     }
 };
 
@@ -3,6 +3,9 @@
 #include "SocketAddress.hpp"
 #include "Resolver.hpp"
 #include <stdint.h>
+#include <chrono>
+#include <memory>
+#include <optional>
 #include <string>
 
 namespace qsox {
@@ -15,24 +18,34 @@ QSOX_MAKE_ERROR_STRUCT(NetworkAddressParseError,
 // NetworkAddress is a class that represents an endpoint on the internet or on a network.
 // It is similar to SocketAddress, but instead of holding an IP address, it holds an opaque string identifying the host.
 // The host can be an IPv4 or IPv6 address, as well as a domain name. It is only resolved to an IP address when needed.
+// Whether the host is an IP literal is decided once when it is set, and DNS results (including failures)
+// are memoized in the object, so repeatedly resolving a long-lived address is cheap.
+// The memo is an immutable snapshot that is swapped atomically, copies share it and moves steal it.
 class NetworkAddress {
 public:
-    NetworkAddress(std::string host, uint16_t port) : m_host(std::move(host)), m_port(port) {}
-    NetworkAddress(const NetworkAddress&) = default;
-    NetworkAddress& operator=(const NetworkAddress&) = default;
-    NetworkAddress(NetworkAddress&&) noexcept = default;
-    NetworkAddress& operator=(NetworkAddress&&) noexcept = default;
+    NetworkAddress(std::string host, uint16_t port) : m_host(std::move(host)), m_port(port) {
+        this->updateLiteral();
+    }
+
+    NetworkAddress(const NetworkAddress& other);
+    NetworkAddress& operator=(const NetworkAddress& other);
+    NetworkAddress(NetworkAddress&& other) noexcept = default;
+    NetworkAddress& operator=(NetworkAddress&& other) noexcept = default;
 
     // allow construction from a SocketAddress
-    NetworkAddress(const SocketAddress& address) : m_host(address.address().toString()), m_port(address.port()) {}
+    NetworkAddress(const SocketAddress& address)
+        : m_host(address.address().toString()), m_port(address.port()), m_literal(address.address()) {}
+
     NetworkAddress& operator=(const SocketAddress& address) {
         m_host = address.address().toString();
         m_port = address.port();
+        m_literal = address.address();
+        this->invalidate();
         return *this;
     }
 
     // allow construction from an IpAddress and port
-    NetworkAddress(const IpAddress& address, uint16_t port) : m_host(address.toString()), m_port(port) {}
+    NetworkAddress(const IpAddress& address, uint16_t port) : m_host(address.toString()), m_port(port), m_literal(address) {}
 
     // comparison operators
     bool operator==(const NetworkAddress& other) const {
@@ -46,6 +59,8 @@ public:
     // setters
     void setHost(const std::string& newm_host) {
         m_host = newm_host;
+        this->updateLiteral();
+        this->invalidate();
     }
 
     void setPort(uint16_t newPort) {
@@ -62,6 +77,11 @@ public:
         return m_port;
     }
 
+    // Returns whether the host is an IPv4 or IPv6 address rather than a domain name
+    bool isIpLiteral() const {
+        return m_literal.has_value();
+    }
+
     // Converts the address to a string.
     // Does not perform any DNS resolution, simply returns 'host:port'.
     std::string toString() const;
@@ -79,9 +99,47 @@ public:
     // SocketAddressV4 unless an IPv4 address is unavailable or the host string is an IPv6 address.
     Result<SocketAddress, resolver::Error> resolve() const;
 
+    // Discards memoized DNS results, the next resolve call will perform a new lookup
+    void invalidate();
+
+    // Sets for how long successful DNS results are memoized by all NetworkAddress objects (default 60 seconds).
+    // A value of 0 disables memoization.
+    static void setResolveTtl(std::chrono::milliseconds ttl);
+    static std::chrono::milliseconds resolveTtl();
+
+    // Same as `setResolveTtl`, for failed lookups (default 5 seconds), so that a dead hostname
+    // doesn't hit DNS on every call. A value of 0 disables memoizing failures.
+    static void setFailedResolveTtl(std::chrono::milliseconds ttl);
+    static std::chrono::milliseconds failedResolveTtl();
+
 private:
+    using Clock = std::chrono::steady_clock;
+
+    enum class CacheSlot : uint8_t {
+        V4, V6, Any
+    };
+
+    struct CachedResult {
+        std::optional<IpAddress> address; // empty if the lookup failed
+        resolver::Error error = resolver::Error::Other;
+        Clock::time_point expiresAt{};
+    };
+
+    // Never modified once published, resolving replaces the whole snapshot
+    struct ResolveSnapshot {
+        std::optional<CachedResult> slots[3];
+    };
+
     std::string m_host;
     uint16_t m_port;
+    std::optional<IpAddress> m_literal;
+    mutable std::shared_ptr<const ResolveSnapshot> m_cache;
+
+    void updateLiteral();
+
+    template <typename F>
+    Result<IpAddress, resolver::Error> resolveCached(CacheSlot slot, F&& resolveFn) const;
+
     friend struct std::hash<NetworkAddress>;
 };
 
@@ -93,7 +151,7 @@ namespace std {
 template <>
 struct hash<qsox::NetworkAddress> {
     size_t operator()(const qsox::NetworkAddress& addr) const {
-        return std::hash<std::string>()(addr.m_host) ^ (std::hash<uint16_t>()(addr.m_port) << 1);
+        return static_cast<size_t>(qsox::hash::combine(std::hash<std::string>()(addr.m_host), addr.m_port));
     }
 };
 
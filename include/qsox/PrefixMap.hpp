@@ -0,0 +1,466 @@
+#pragma once
+
+#include "IpNetwork.hpp"
+#include <algorithm>
+#include <bit>
+#include <utility>
+#include <vector>
+
+namespace qsox {
+
+namespace detail {
+
+// Key representations used by the tries, the most significant bit is the first bit of the address
+
+struct PrefixKey128 {
+    uint64_t hi = 0;
+    uint64_t lo = 0;
+
+    constexpr bool operator==(const PrefixKey128&) const = default;
+};
+
+inline uint32_t prefixKey(const Ipv4Address& addr) {
+    return addr.toBits();
+}
+
+inline PrefixKey128 prefixKey(const Ipv6Address& addr) {
+    auto& o = addr.octets();
+    PrefixKey128 key;
+
+    for (size_t i = 0; i < 8; i++) {
+        key.hi = key.hi << 8 | o[i];
+        key.lo = key.lo << 8 | o[i + 8];
+    }
+
+    return key;
+}
+
+// Returns the first 16 bits of the key
+inline uint16_t prefixTop16(uint32_t key) {
+    return static_cast<uint16_t>(key >> 16);
+}
+
+inline uint16_t prefixTop16(const PrefixKey128& key) {
+    return static_cast<uint16_t>(key.hi >> 48);
+}
+
+inline bool prefixBit(uint32_t key, uint8_t index) {
+    return (key >> (31 - index)) & 1;
+}
+
+inline bool prefixBit(const PrefixKey128& key, uint8_t index) {
+    return index < 64 ? (key.hi >> (63 - index)) & 1 : (key.lo >> (127 - index)) & 1;
+}
+
+// Returns the amount of leading bits that are equal in both keys
+inline uint8_t commonPrefix(uint32_t a, uint32_t b) {
+    return static_cast<uint8_t>(std::countl_zero(a ^ b));
+}
+
+inline uint8_t commonPrefix(const PrefixKey128& a, const PrefixKey128& b) {
+    if (a.hi != b.hi) {
+        return static_cast<uint8_t>(std::countl_zero(a.hi ^ b.hi));
+    }
+
+    return static_cast<uint8_t>(64 + std::countl_zero(a.lo ^ b.lo));
+}
+
+// Returns whether the first `len` bits of both keys are equal
+inline bool prefixMatches(uint32_t a, uint32_t b, uint8_t len) {
+    return len == 0 || ((a ^ b) >> (32 - len)) == 0;
+}
+
+inline bool prefixMatches(const PrefixKey128& a, const PrefixKey128& b, uint8_t len) {
+    if (len <= 64) {
+        return len == 0 || ((a.hi ^ b.hi) >> (64 - len)) == 0;
+    }
+
+    return a.hi == b.hi && ((a.lo ^ b.lo) >> (128 - len)) == 0;
+}
+
+// Path compressed binary trie stored in a flat array.
+// Every node covers a prefix, and only has children where the prefixes below it diverge,
+// so a lookup visits at most one node per distinct prefix length along the path.
+//
+// Large tries additionally get a direct-indexed first level (like poptrie or DIR-16), built by `compact()`.
+// It maps the first 16 bits of a key to the best match among prefixes shorter than 16 bits, and to the node
+// where the walk continues, which skips the densest part of the trie.
+template <typename Key, uint8_t Bits>
+class PrefixTrie {
+public:
+    static constexpr uint32_t None = ~uint32_t(0);
+
+    // Tries with fewer nodes than this don't get a first level table, it takes 512 KiB
+    static constexpr size_t JumpTableThreshold = 4096;
+
+    struct Node {
+        Key key;
+        uint8_t len;
+        bool hasValue;
+        uint32_t value;
+        uint32_t child[2];
+    };
+
+    // Inserts a prefix with the given value index. If the prefix is already present,
+    // it is left untouched and its existing value index is returned, otherwise returns `None`.
+    uint32_t insert(const Key& key, uint8_t len, uint32_t value) {
+        // the table would be out of date, it is rebuilt by the next compact()
+        m_jump.clear();
+
+        if (m_root == None) {
+            m_root = this->newNode(key, len, value);
+            return None;
+        }
+
+        uint32_t parent = None;
+        uint32_t idx = m_root;
+
+        while (true) {
+            Node& node = m_nodes[idx];
+            uint8_t common = std::min({commonPrefix(node.key, key), node.len, len});
+
+            if (common < node.len) {
+                // the new prefix diverges from (or is shorter than) this node, split it
+                uint32_t split;
+
+                if (common == len) {
+                    split = this->newNode(key, len, value);
+                } else {
+                    split = this->newNode(key, common, None);
+                    uint32_t leaf = this->newNode(key, len, value);
+                    m_nodes[split].child[prefixBit(key, common)] = leaf;
+                }
+
+                m_nodes[split].child[prefixBit(m_nodes[idx].key, common)] = idx;
+                this->replaceChild(parent, idx, split);
+                return None;
+            }
+
+            if (len == node.len) {
+                if (node.hasValue) {
+                    return node.value;
+                }
+
+                // node was created by a split, it becomes a real prefix now
+                node.hasValue = true;
+                node.value = value;
+                return None;
+            }
+
+            bool bit = prefixBit(key, node.len);
+            if (node.child[bit] == None) {
+                uint32_t leaf = this->newNode(key, len, value);
+                m_nodes[idx].child[bit] = leaf;
+                return None;
+            }
+
+            parent = idx;
+            idx = node.child[bit];
+        }
+    }
+
+    // Returns the value index of the longest prefix containing `key`, or `None`
+    uint32_t longestMatch(const Key& key) const {
+        uint32_t best = None;
+        uint32_t idx = m_root;
+
+        if (!m_jump.empty()) {
+            auto& entry = m_jump[prefixTop16(key)];
+            best = entry.best;
+            idx = entry.node;
+        }
+
+        while (idx != None) {
+            const Node& node = m_nodes[idx];
+
+            if (!prefixMatches(node.key, key, node.len)) {
+                break;
+            }
+
+            if (node.hasValue) {
+                best = node.value;
+            }
+
+            if (node.len == Bits) {
+                break;
+            }
+
+            idx = node.child[prefixBit(key, node.len)];
+        }
+
+        return best;
+    }
+
+    // Returns the value index of the exact prefix, or `None`
+    uint32_t find(const Key& key, uint8_t len) const {
+        uint32_t idx = m_root;
+
+        while (idx != None) {
+            const Node& node = m_nodes[idx];
+
+            if (node.len > len || !prefixMatches(node.key, key, node.len)) {
+                break;
+            }
+
+            if (node.len == len) {
+                return node.hasValue ? node.value : None;
+            }
+
+            idx = node.child[prefixBit(key, node.len)];
+        }
+
+        return None;
+    }
+
+    // Reorders the nodes so that every node is directly followed by its first child,
+    // which keeps the nodes visited by a lookup close together in memory.
+    void compact() {
+        if (m_root == None) {
+            // release whatever was reserved for an empty trie
+            std::vector<Node>().swap(m_nodes);
+            return;
+        }
+
+        std::vector<Node> nodes;
+        nodes.reserve(m_nodes.size());
+
+        // pairs of (old index, slot in the new array that must point to its new index)
+        std::vector<std::pair<uint32_t, uint32_t*>> stack;
+        uint32_t newRoot = None;
+        stack.emplace_back(m_root, &newRoot);
+
+        // the slots point into `nodes`, which never reallocates as it was reserved for all nodes up front
+        while (!stack.empty()) {
+            auto [old, slot] = stack.back();
+            stack.pop_back();
+
+            *slot = static_cast<uint32_t>(nodes.size());
+            nodes.push_back(m_nodes[old]);
+            Node& node = nodes.back();
+
+            if (node.child[1] != None) {
+                stack.emplace_back(node.child[1], &node.child[1]);
+            }
+
+            if (node.child[0] != None) {
+                stack.emplace_back(node.child[0], &node.child[0]);
+            }
+        }
+
+        m_nodes = std::move(nodes);
+        m_root = newRoot;
+
+        this->buildJumpTable();
+    }
+
+    void reserve(size_t nodes) {
+        m_nodes.reserve(nodes);
+    }
+
+    void clear() {
+        m_nodes.clear();
+        m_jump.clear();
+        m_root = None;
+    }
+
+    size_t nodeCount() const {
+        return m_nodes.size();
+    }
+
+private:
+    struct JumpEntry {
+        // value index of the longest prefix shorter than 16 bits covering this slot
+        uint32_t best;
+        // first node with a prefix of at least 16 bits within this slot, the walk continues from there
+        uint32_t node;
+    };
+
+    std::vector<Node> m_nodes;
+    std::vector<JumpEntry> m_jump;
+    uint32_t m_root = None;
+
+    void buildJumpTable() {
+        m_jump.clear();
+
+        if (m_nodes.size() < JumpTableThreshold) {
+            return;
+        }
+
+        m_jump.assign(size_t(1) << 16, JumpEntry{None, None});
+
+        // nodes shorter than 16 bits are resolved into the table, nodes are visited parents first,
+        // so more specific prefixes overwrite the ranges of the ones covering them
+        std::vector<uint32_t> stack{m_root};
+
+        while (!stack.empty()) {
+            uint32_t idx = stack.back();
+            stack.pop_back();
+
+            const Node& node = m_nodes[idx];
+            size_t slot = prefixTop16(node.key);
+
+            if (node.len >= 16) {
+                m_jump[slot].node = idx;
+                continue;
+            }
+
+            if (node.hasValue) {
+                size_t count = size_t(1) << (16 - node.len);
+                size_t start = slot & ~(count - 1);
+
+                for (size_t i = start; i < start + count; i++) {
+                    m_jump[i].best = node.value;
+                }
+            }
+
+            for (uint32_t child : node.child) {
+                if (child != None) {
+                    stack.push_back(child);
+                }
+            }
+        }
+    }
+
+    uint32_t newNode(const Key& key, uint8_t len, uint32_t value) {
+        Node node{};
+        node.key = key;
+        node.len = len;
+        node.hasValue = value != None;
+        node.value = value;
+        node.child[0] = None;
+        node.child[1] = None;
+
+        m_nodes.push_back(node);
+        return static_cast<uint32_t>(m_nodes.size() - 1);
+    }
+
+    void replaceChild(uint32_t parent, uint32_t from, uint32_t to) {
+        if (parent == None) {
+            m_root = to;
+            return;
+        }
+
+        auto& children = m_nodes[parent].child;
+        children[children[0] == from ? 0 : 1] = to;
+    }
+};
+
+} // namespace detail
+
+// Map from IP networks to values, supporting longest prefix match lookups (e.g. routing tables or ACLs).
+// IPv4 and IPv6 prefixes are kept in separate tries, an IPv4-mapped IPv6 address only matches IPv6 networks.
+// Nodes live in flat arrays, use `build` when all prefixes are known up front to also get a cache friendly layout.
+template <typename T>
+class PrefixMap {
+public:
+    PrefixMap() = default;
+
+    // Builds a map from a list of prefixes, later duplicates replace earlier ones.
+    static PrefixMap build(std::vector<std::pair<IpNetwork, T>> entries) {
+        PrefixMap map;
+
+        // insert shorter prefixes first, so covering prefixes become branch nodes right away instead of being spliced in later
+        std::stable_sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+            return a.first.prefixLength() < b.first.prefixLength();
+        });
+
+        size_t v4Count = std::count_if(entries.begin(), entries.end(), [](const auto& e) { return e.first.isV4(); });
+
+        map.m_values.reserve(entries.size());
+        map.m_v4.reserve(v4Count * 2);
+        map.m_v6.reserve((entries.size() - v4Count) * 2);
+
+        for (auto& [network, value] : entries) {
+            map.insert(network, std::move(value));
+        }
+
+        map.compact();
+        return map;
+    }
+
+    // Inserts a value for the network, replacing the existing one if the network is already present.
+    void insert(const Ipv4Network& network, T value) {
+        this->insertInto(m_v4, detail::prefixKey(network.address()), network.prefixLength(), std::move(value));
+    }
+
+    void insert(const Ipv6Network& network, T value) {
+        this->insertInto(m_v6, detail::prefixKey(network.address()), network.prefixLength(), std::move(value));
+    }
+
+    void insert(const IpNetwork& network, T value) {
+        if (network.isV4()) {
+            this->insert(network.asV4(), std::move(value));
+        } else {
+            this->insert(network.asV6(), std::move(value));
+        }
+    }
+
+    // Returns the value of the most specific network containing the address, or nullptr if there is none.
+    const T* lookup(const Ipv4Address& addr) const {
+        return this->value(m_v4.longestMatch(detail::prefixKey(addr)));
+    }
+
+    const T* lookup(const Ipv6Address& addr) const {
+        return this->value(m_v6.longestMatch(detail::prefixKey(addr)));
+    }
+
+    const T* lookup(const IpAddress& addr) const {
+        return addr.isV4() ? this->lookup(addr.asV4()) : this->lookup(addr.asV6());
+    }
+
+    // Returns the value of exactly this network, or nullptr if it was never inserted.
+    const T* find(const IpNetwork& network) const {
+        if (network.isV4()) {
+            auto& net = network.asV4();
+            return this->value(m_v4.find(detail::prefixKey(net.address()), net.prefixLength()));
+        } else {
+            auto& net = network.asV6();
+            return this->value(m_v6.find(detail::prefixKey(net.address()), net.prefixLength()));
+        }
+    }
+
+    // Relayouts the tries for faster lookups, worth calling once after many individual inserts.
+    void compact() {
+        m_v4.compact();
+        m_v6.compact();
+    }
+
+    size_t size() const {
+        return m_values.size();
+    }
+
+    bool empty() const {
+        return m_values.empty();
+    }
+
+    void clear() {
+        m_v4.clear();
+        m_v6.clear();
+        m_values.clear();
+    }
+
+private:
+    using Trie4 = detail::PrefixTrie<uint32_t, 32>;
+    using Trie6 = detail::PrefixTrie<detail::PrefixKey128, 128>;
+
+    Trie4 m_v4;
+    Trie6 m_v6;
+    std::vector<T> m_values;
+
+    template <typename Trie, typename Key>
+    void insertInto(Trie& trie, const Key& key, uint8_t len, T&& value) {
+        uint32_t previous = trie.insert(key, len, static_cast<uint32_t>(m_values.size()));
+
+        if (previous != Trie::None) {
+            m_values[previous] = std::move(value);
+        } else {
+            m_values.push_back(std::move(value));
+        }
+    }
+
+    const T* value(uint32_t index) const {
+        return index == detail::PrefixTrie<uint32_t, 32>::None ? nullptr : &m_values[index];
+    }
+};
+
+} // namespace qsox
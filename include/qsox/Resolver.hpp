@@ -38,6 +38,17 @@ Result<Ipv6Address> resolveIpv6(const std::string& hostname, int timeoutMs = 0);
 /// Note that the timeout is applied separately per lookup, instead of on the whole function.
 Result<IpAddress> resolve(const std::string& hostname, int timeoutMs = 0);
 
+/// Looks up the hostname in the system hosts file (/etc/hosts on Unix), without performing any DNS queries.
+/// The file is kept parsed in memory and is reloaded when it changes.
+/// `resolveIpv4` and `resolveIpv6` check the hosts file before querying the system resolver.
+std::optional<Ipv4Address> lookupHostsIpv4(std::string_view hostname);
+/// Looks up the hostname in the system hosts file (/etc/hosts on Unix), without performing any DNS queries.
+std::optional<Ipv6Address> lookupHostsIpv6(std::string_view hostname);
+
+/// Performs a reverse (PTR) lookup of the given address, returning the hostname it belongs to.
+/// This function blocks until the lookup completes, use `ReverseResolver` for asynchronous cached lookups.
+Result<std::string> reverseLookup(const IpAddress& address);
+
 Error makeError(int code);
 
 } // namespace qsox
\ No newline at end of file
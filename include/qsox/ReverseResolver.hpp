@@ -0,0 +1,98 @@
+#pragma once
+
+// Asynchronous reverse DNS lookups with a bounded cache
+
+#include "Resolver.hpp"
+#include <chrono>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace qsox {
+class BackgroundWorker;
+}
+
+namespace qsox::resolver {
+
+struct ReverseCacheOptions {
+    // Maximum amount of cached results, least recently used ones are evicted first.
+    size_t capacity = 4096;
+
+    // How long a successful lookup is cached.
+    std::chrono::milliseconds ttl{300000};
+
+    // How long a failed lookup (e.g. no PTR record) is cached.
+    std::chrono::milliseconds negativeTtl{60000};
+
+    // Amount of background threads performing lookups. They share one queue, so a slow lookup
+    // doesn't hold up the ones submitted after it.
+    size_t threads = 2;
+
+    // Maximum amount of lookups waiting for a result (queued or in progress, merged lookups of the same
+    // address count once per callback). Lookups beyond that fail immediately with `Error::TemporaryFailure`,
+    // which is not cached, so the address can be looked up again once the backlog has cleared.
+    size_t maxPending = 1024;
+};
+
+// Performs reverse (PTR) lookups on background threads and caches the results, including failures.
+// None of the methods block on DNS, which makes this suitable for enriching logs on the request path.
+class ReverseResolver {
+public:
+    using Callback = std::function<void(const IpAddress& address, const Result<std::string>& result)>;
+
+    ReverseResolver(ReverseCacheOptions options = {});
+    ~ReverseResolver();
+
+    ReverseResolver(const ReverseResolver&) = delete;
+    ReverseResolver& operator=(const ReverseResolver&) = delete;
+
+    // Returns a process-wide resolver instance with default options
+    static ReverseResolver& global();
+
+    // Returns the cached result for the address, if there is one.
+    // This never starts a lookup.
+    std::optional<Result<std::string>> cached(const IpAddress& address);
+
+    // Looks up the address, invoking the callback once the result is known.
+    // If the result is cached, the callback is invoked immediately on the calling thread,
+    // otherwise it is invoked on a background thread. Concurrent lookups of the same address are merged.
+    // If `maxPending` lookups are already waiting, the callback is invoked immediately with `Error::TemporaryFailure`.
+    void lookup(const IpAddress& address, Callback callback);
+
+    // Same as `lookup`, but returns a future instead of invoking a callback.
+    std::shared_future<Result<std::string>> lookup(const IpAddress& address);
+
+    // Removes all cached results
+    void clear();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        IpAddress address;
+        Result<std::string> result;
+        Clock::time_point expiresAt;
+    };
+
+    ReverseCacheOptions m_options;
+    std::mutex m_mutex;
+
+    // most recently used entries are at the front
+    std::list<Entry> m_lru;
+    std::unordered_map<IpAddress, std::list<Entry>::iterator> m_entries;
+    std::unordered_map<IpAddress, std::vector<Callback>> m_pending;
+    size_t m_pendingCallbacks = 0;
+
+    std::unique_ptr<BackgroundWorker> m_worker;
+
+    std::optional<Result<std::string>> findLocked(const IpAddress& address);
+    void complete(const IpAddress& address, Result<std::string> result);
+};
+
+} // namespace qsox::resolver
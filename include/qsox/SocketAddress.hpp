@@ -18,6 +18,9 @@ QSOX_MAKE_ERROR_STRUCT(SocketAddressParseError,
 // Socket address that contains an Ipv4/Ipv6 address and a port.
 class SocketAddress {
 public:
+    // Maximum length of the string representation
+    static constexpr size_t MaxStringLength = SocketAddressV6::MaxStringLength;
+
     constexpr SocketAddress() : SocketAddress(SocketAddressV4{}) {}
     constexpr SocketAddress(const IpAddress& addr, uint16_t port = 0) : m_address(addr), m_port(port) {}
     constexpr SocketAddress(const SocketAddressV4& addr) : m_address(addr.address()), m_port(addr.port()) {}
@@ -122,7 +125,45 @@ public:
     // Parsing/formatting
 
     std::string toString() const;
+    // Writes the string representation into `buf`, which must hold at least `MaxStringLength` characters.
+    // Returns the pointer past the last written character, no null terminator is written.
+    char* toChars(char* buf) const;
     static Result<SocketAddress, SocketAddressParseError> parse(std::string_view str);
+
+    // Same as `parse`, but usable in constant expressions, see also the `_sa` literal.
+    // At runtime `parse` should be preferred, as it is faster.
+    static constexpr std::optional<SocketAddress> parseConstexpr(std::string_view str) {
+        auto colonPos = str.rfind(':');
+        if (colonPos == std::string_view::npos || colonPos == 0 || colonPos == str.size() - 1) {
+            return std::nullopt;
+        }
+
+        std::string_view addressPart = str.substr(0, colonPos);
+        std::string_view portPart = str.substr(colonPos + 1);
+
+        uint32_t port = 0;
+        for (char c : portPart) {
+            if (c < '0' || c > '9') {
+                return std::nullopt;
+            }
+
+            port = port * 10 + static_cast<uint32_t>(c - '0');
+            if (port > 65535) {
+                return std::nullopt;
+            }
+        }
+
+        // if the address is enclosed in square brackets, it must be ipv6
+        if (addressPart.size() >= 2 && addressPart.front() == '[' && addressPart.back() == ']') {
+            if (auto addr = Ipv6Address::parseBareConstexpr(addressPart.substr(1, addressPart.size() - 2))) {
+                return SocketAddress{*addr, static_cast<uint16_t>(port)};
+            }
+        } else if (auto addr = Ipv4Address::parseConstexpr(addressPart)) {
+            return SocketAddress{*addr, static_cast<uint16_t>(port)};
+        }
+
+        return std::nullopt;
+    }
     static SocketAddress fromSockAddr(const sockaddr& addr);
 
     // Returns the address family (AF_INET or AF_INET6)
@@ -135,6 +176,21 @@ private:
     friend struct std::hash<SocketAddress>;
 };
 
+// Socket address literals, e.g. `constexpr auto addr = "[::1]:80"_sa;`
+// Parsing happens at compile time, and a malformed literal is a compile error.
+inline namespace literals {
+
+consteval SocketAddress operator""_sa(const char* str, size_t len) {
+    auto addr = SocketAddress::parseConstexpr(std::string_view{str, len});
+    if (!addr) {
+        detail::invalidLiteral("invalid socket address literal");
+    }
+
+    return *addr;
+}
+
+} // namespace literals
+
 } // namespace qsox
 
 // hash
@@ -143,9 +199,11 @@ namespace std {
 template <>
 struct hash<qsox::SocketAddress> {
     size_t operator()(const qsox::SocketAddress& addr) const {
-        size_t h1 = std::hash<qsox::IpAddress>()(addr.m_address);
-        size_t h2 = std::hash<uint16_t>()(addr.m_port);
-        return h1 ^ (h2 << 1);
+        // same as the hash of the equivalent SocketAddressV4/V6
+        uint64_t h = addr.m_address.isV4()
+            ? qsox::hash::hashIpv4(addr.m_address.asV4().toBits(), addr.m_port)
+            : qsox::hash::hashIpv6(addr.m_address.asV6().octets().data(), addr.m_port);
+        return static_cast<size_t>(h);
     }
 };
 
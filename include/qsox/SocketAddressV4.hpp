@@ -17,6 +17,9 @@ QSOX_MAKE_ERROR_STRUCT(SocketAddressV4ParseError,
 
 class SocketAddressV4 {
 public:
+    // Maximum length of the string representation ('255.255.255.255:65535')
+    static constexpr size_t MaxStringLength = Ipv4Address::MaxStringLength + 6;
+
     constexpr SocketAddressV4() : m_address(Ipv4Address{}), m_port(0) {}
     constexpr SocketAddressV4(const Ipv4Address& address, uint16_t port = 0) : m_address(address), m_port(port) {}
     constexpr SocketAddressV4(const SocketAddressV4& other) = default;
@@ -56,6 +59,9 @@ public:
 
     static Result<SocketAddressV4, SocketAddressV4ParseError> parse(std::string_view str);
     std::string toString() const;
+    // Writes the string representation into `buf`, which must hold at least `MaxStringLength` characters.
+    // Returns the pointer past the last written character, no null terminator is written.
+    char* toChars(char* buf) const;
     void toSockAddr(sockaddr_in& addr) const;
     static SocketAddressV4 fromSockAddr(const sockaddr_in& addr);
 
@@ -74,9 +80,7 @@ namespace std {
 template <>
 struct hash<qsox::SocketAddressV4> {
     size_t operator()(const qsox::SocketAddressV4& addr) const {
-        size_t h1 = std::hash<qsox::Ipv4Address>()(addr.address());
-        size_t h2 = std::hash<uint16_t>()(addr.port());
-        return h1 ^ (h2 << 1);
+        return static_cast<size_t>(qsox::hash::hashIpv4(addr.address().toBits(), addr.port()));
     }
 };
 
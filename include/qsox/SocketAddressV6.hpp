@@ -16,6 +16,9 @@ QSOX_MAKE_ERROR_STRUCT(SocketAddressV6ParseError,
 
 class SocketAddressV6 {
 public:
+    // Maximum length of the string representation ('[' + address + ']:65535')
+    static constexpr size_t MaxStringLength = Ipv6Address::MaxStringLength + 8;
+
     constexpr SocketAddressV6() : m_address(Ipv6Address{}), m_port(0) {}
     constexpr SocketAddressV6(const Ipv6Address& address, uint16_t port = 0) : m_address(address), m_port(port) {}
     constexpr SocketAddressV6(const SocketAddressV6& other) = default;
@@ -55,6 +58,9 @@ public:
 
     static Result<SocketAddressV6, SocketAddressV6ParseError> parse(std::string_view str);
     std::string toString() const;
+    // Writes the string representation into `buf`, which must hold at least `MaxStringLength` characters.
+    // Returns the pointer past the last written character, no null terminator is written.
+    char* toChars(char* buf) const;
     void toSockAddr(sockaddr_in6& addr) const;
     static SocketAddressV6 fromSockAddr(const sockaddr_in6& addr);
 
@@ -73,9 +79,7 @@ namespace std {
 template <>
 struct hash<qsox::SocketAddressV6> {
     size_t operator()(const qsox::SocketAddressV6& addr) const {
-        size_t h1 = std::hash<qsox::Ipv6Address>()(addr.address());
-        size_t h2 = std::hash<uint16_t>()(addr.port());
-        return h1 ^ (h2 << 1);
+        return static_cast<size_t>(qsox::hash::hashIpv6(addr.address().octets().data(), addr.port()));
     }
 };
 
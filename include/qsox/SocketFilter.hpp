@@ -0,0 +1,106 @@
+#pragma once
+
+// Kernel-side packet filtering with classic BPF (SO_ATTACH_FILTER).
+// Packets rejected by an attached filter are dropped by the kernel before they are queued on the socket,
+// so they never cost a syscall or an address conversion in userspace. Only supported on Linux.
+
+#include "IpNetwork.hpp"
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace qsox {
+
+QSOX_MAKE_ERROR_STRUCT(SocketFilterError,
+    TooManyInstructions,
+    InvalidRange,
+);
+
+// A single classic BPF instruction, layout compatible with `struct sock_filter`
+struct SocketFilterInstruction {
+    uint16_t code;
+    uint8_t jt;
+    uint8_t jf;
+    uint32_t k;
+};
+
+// A compiled classic BPF program, see `BaseSocket::attachFilter`.
+// The program sees the packet starting at the transport (UDP/TCP) header,
+// and the IP header is reachable through the SKF_NET_OFF negative offset.
+class SocketFilter {
+public:
+    // Maximum amount of instructions the kernel accepts (BPF_MAXINSNS)
+    static constexpr size_t MaxInstructions = 4096;
+
+    SocketFilter() = default;
+    explicit SocketFilter(std::vector<SocketFilterInstruction> program) : m_program(std::move(program)) {}
+
+    const std::vector<SocketFilterInstruction>& instructions() const {
+        return m_program;
+    }
+
+    size_t size() const {
+        return m_program.size();
+    }
+
+private:
+    std::vector<SocketFilterInstruction> m_program;
+};
+
+// Builds a filter out of common rules. A packet is accepted only if it passes every configured rule:
+//  * its payload length is within the configured bounds
+//  * its payload starts with all the configured byte sequences
+//  * its source port is not in a denied range, and is in one of the allowed ranges (if any were added)
+//  * its source address is not in a denied network, and is in one of the allowed networks (if any were added)
+//
+// Payload rules assume an 8 byte UDP header and are only meaningful for UDP sockets,
+// address and port rules work for both UDP and TCP.
+class SocketFilterBuilder {
+public:
+    // Drops packets coming from addresses within the network
+    SocketFilterBuilder& denySource(const IpNetwork& network);
+
+    // Once any network is allowed, packets coming from addresses outside of all allowed networks are dropped.
+    // Note that this applies to both address families, allowing only IPv4 networks drops all IPv6 traffic.
+    SocketFilterBuilder& allowSource(const IpNetwork& network);
+
+    // Drops packets whose source port is within [first, last]
+    SocketFilterBuilder& denySourcePorts(uint16_t first, uint16_t last);
+
+    // Once any range is allowed, packets whose source port is outside of all allowed ranges are dropped
+    SocketFilterBuilder& allowSourcePorts(uint16_t first, uint16_t last);
+
+    // Drops datagrams with a payload shorter than `length` bytes
+    SocketFilterBuilder& minPayloadLength(uint16_t length);
+
+    // Drops datagrams with a payload longer than `length` bytes
+    SocketFilterBuilder& maxPayloadLength(uint16_t length);
+
+    // Drops datagrams whose payload does not contain `bytes` at `offset`, e.g. a protocol magic number
+    SocketFilterBuilder& requirePayloadBytes(const void* bytes, size_t size, uint16_t offset = 0);
+
+    // Compiles the rules into a BPF program
+    Result<SocketFilter, SocketFilterError> build() const;
+
+private:
+    struct PortRange {
+        uint16_t first;
+        uint16_t last;
+    };
+
+    struct PayloadBytes {
+        uint16_t offset;
+        std::vector<uint8_t> bytes;
+    };
+
+    std::vector<IpNetwork> m_deniedSources;
+    std::vector<IpNetwork> m_allowedSources;
+    std::vector<PortRange> m_deniedPorts;
+    std::vector<PortRange> m_allowedPorts;
+    std::vector<PayloadBytes> m_payloadBytes;
+    uint16_t m_minPayload = 0;
+    uint16_t m_maxPayload = UINT16_MAX;
+    bool m_invalidRange = false;
+};
+
+} // namespace qsox
@@ -4,8 +4,21 @@
 
 namespace qsox {
 
+// Progress of a `sendAll`/`receiveExact` call, for non-blocking streams. When the call fails with `WouldBlock`,
+// `transferred` holds how much was already sent/received, and calling again with the same buffer and cursor
+// (e.g. after the next readiness event) continues where it stopped.
+struct TransferCursor {
+    size_t transferred = 0;
+
+    void reset() {
+        transferred = 0;
+    }
+};
+
 class TcpStream : public BaseSocket {
 public:
+    using Deadline = std::chrono::steady_clock::time_point;
+
     // Creates a new TCP stream, connecting to the given address.
     // Default timeout is 5000ms and can be changed via the `timeoutMs` parameter.
     // If the timeout is set to 0ms, the function may block indefinitely.
@@ -34,12 +47,34 @@ public:
     // Sends data over this socket, blocking until all data is sent, or an error occurs.
     NetResult<> sendAll(const void* data, size_t size);
 
+    // Same as `sendAll`, but resumable, starting at and advancing `cursor.transferred`.
+    // On a non-blocking stream this sends as much as possible and fails with `WouldBlock`, keeping the progress.
+    NetResult<> sendAll(const void* data, size_t size, TransferCursor& cursor);
+
+    // Sends data over this socket, blocking until all data is sent, an error occurs, or the deadline passes,
+    // in which case `TimedOut` is returned. The deadline bounds the whole call, unlike the per-call write timeout.
+    // Sends are attempted without blocking first, so the clock is only read when the socket has to be waited for.
+    NetResult<> sendAll(const void* data, size_t size, Deadline deadline);
+
     // Receives data from the socket. Returns amount of bytes received.
     NetResult<size_t> receive(void* buffer, size_t size);
 
+    // Receives data from the socket, along with the time the most recent of the received segments arrived,
+    // if timestamping is enabled (see `BaseSocket::enableTimestamping`). Returns amount of bytes received.
+    // If the control data was truncated (too many other ancillary options enabled), the timestamp is left empty.
+    // Not supported on Windows, fails with `Unimplemented` there.
+    NetResult<size_t> receive(void* buffer, size_t size, PacketTimestamp& timestamp);
+
     // Receives data from the socket, blocking until the given buffer is full or an error occurs.
     NetResult<> receiveExact(void* buffer, size_t size);
 
+    // Same as `receiveExact`, but resumable, see the `sendAll` overload taking a `TransferCursor`
+    NetResult<> receiveExact(void* buffer, size_t size, TransferCursor& cursor);
+
+    // Same as `receiveExact`, but fails with `TimedOut` if the buffer isn't filled before the deadline,
+    // see the `sendAll` overload taking a deadline.
+    NetResult<> receiveExact(void* buffer, size_t size, Deadline deadline);
+
     // Peeks at incoming data without removing it from the queue.
     NetResult<size_t> peek(void* buffer, size_t size);
 
@@ -49,6 +84,7 @@ public:
 private:
     TcpStream(SockFd fd);
 
+    NetResult<size_t> _send(const void* data, size_t size, int flags);
     NetResult<size_t> _receive(void* buffer, size_t size, int flags);
 
     static NetResult<TcpStream> connectInternal(const SocketAddress& address, bool nonBlocking, int timeoutMs);
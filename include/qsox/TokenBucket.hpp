@@ -0,0 +1,118 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+
+namespace qsox {
+
+// Token bucket rate limiter for pacing sends in user space, for when the kernel can't pace
+// (no SO_MAX_PACING_RATE / SO_TXTIME, or no fq/etf qdisc on the interface).
+// Tokens are usually bytes: the bucket refills at `rate` tokens per second and holds at most `burst` tokens.
+//
+// Internally this is the GCRA (virtual scheduling) form of a token bucket, which only tracks the time at which
+// the bucket will be full again, so there is no refill step and no floating point. The fractional nanoseconds
+// left over by each cost are carried over, so the average rate is exact.
+//
+// Nothing here sleeps: `tryConsume` tells whether a send may happen now, `timeUntil` how long to wait
+// (e.g. as a poll timeout), and `reserve` schedules the send and returns its departure time,
+// which can be passed straight to `UdpSocket::sendAt`. Not thread safe.
+// Rates above 10^10 tokens per second are not supported.
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+    using Duration = std::chrono::nanoseconds;
+
+    // Creates a full bucket. `rate` must not be zero, and `burst` should be at least as large as the largest consume,
+    // otherwise such consumes never succeed with `tryConsume`.
+    TokenBucket(uint64_t rate, uint64_t burst, TimePoint now = Clock::now()) : m_full(now) {
+        this->setRate(rate, burst);
+    }
+
+    // Changes the rate and burst size. The time until the bucket is full again stays the same.
+    void setRate(uint64_t rate, uint64_t burst) {
+        m_rate = std::max<uint64_t>(rate, 1);
+        m_burst = burst;
+        m_remainder = 0;
+
+        // rounded up, so that a full burst always fits
+        m_tolerance = this->cost(burst);
+        m_tolerance += Duration{m_remainder != 0 ? 1 : 0};
+        m_remainder = 0;
+    }
+
+    uint64_t rate() const {
+        return m_rate;
+    }
+
+    uint64_t burst() const {
+        return m_burst;
+    }
+
+    // Takes `tokens` from the bucket if that many are available, returns false (and takes nothing) otherwise
+    bool tryConsume(uint64_t tokens, TimePoint now = Clock::now()) {
+        uint64_t remainder = m_remainder;
+        TimePoint full = std::max(m_full, now) + this->cost(tokens);
+
+        if (full - m_tolerance > now) {
+            m_remainder = remainder;
+            return false;
+        }
+
+        m_full = full;
+        return true;
+    }
+
+    // Takes `tokens` from the bucket even if not enough are available, going into debt.
+    // Returns the time at which they would have been available, which is `now` or later.
+    TimePoint reserve(uint64_t tokens, TimePoint now = Clock::now()) {
+        m_full = std::max(m_full, now) + this->cost(tokens);
+        return std::max(now, m_full - m_tolerance);
+    }
+
+    // Returns how long until `tokens` can be consumed, zero if they can be consumed now
+    Duration timeUntil(uint64_t tokens, TimePoint now = Clock::now()) const {
+        TimePoint full = std::max(m_full, now) + Duration{this->costNoCarry(tokens)};
+        return std::max(Duration{0}, full - m_tolerance - now);
+    }
+
+    // Returns the amount of tokens currently in the bucket, 0 if it is in debt
+    uint64_t available(TimePoint now = Clock::now()) const {
+        auto missing = std::max(Duration{0}, m_full - now);
+        if (missing >= m_tolerance) {
+            return 0;
+        }
+
+        return std::min(m_burst, this->tokensFor(m_tolerance - missing));
+    }
+
+private:
+    static constexpr uint64_t NsPerSecond = 1'000'000'000;
+
+    TimePoint m_full; // time at which the bucket is full again
+    Duration m_tolerance{0}; // time it takes to refill a whole burst
+    uint64_t m_rate = 1;
+    uint64_t m_burst = 0;
+    uint64_t m_remainder = 0; // fractional nanoseconds carried over, in units of 1/rate
+
+    // Time it takes to refill `tokens` tokens
+    Duration cost(uint64_t tokens) {
+        uint64_t whole = tokens / m_rate * NsPerSecond;
+        uint64_t frac = tokens % m_rate * NsPerSecond + m_remainder;
+
+        m_remainder = frac % m_rate;
+        return Duration{static_cast<int64_t>(whole + frac / m_rate)};
+    }
+
+    int64_t costNoCarry(uint64_t tokens) const {
+        return static_cast<int64_t>(tokens / m_rate * NsPerSecond + (tokens % m_rate * NsPerSecond + m_remainder) / m_rate);
+    }
+
+    uint64_t tokensFor(Duration time) const {
+        uint64_t ns = static_cast<uint64_t>(time.count());
+        return ns / NsPerSecond * m_rate + ns % NsPerSecond * m_rate / NsPerSecond;
+    }
+};
+
+} // namespace qsox
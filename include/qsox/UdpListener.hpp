@@ -0,0 +1,64 @@
+#pragma once
+
+#include "AddressMap.hpp"
+#include "UdpSocket.hpp"
+
+namespace qsox {
+
+// A peer accepted by `UdpListener`
+struct UdpAccepted {
+    // Socket connected to the peer, receiving all further datagrams from it
+    UdpSocket socket;
+    SocketAddress peer;
+    // Size of the first datagram, which was received by the listener and written to the buffer passed to `accept`
+    size_t size;
+};
+
+// Gives every UDP peer its own connected socket, similarly to a TCP listener.
+//
+// The listener socket receives the first datagram from a new peer. `accept` then creates another socket bound
+// to the same local address (with SO_REUSEPORT) and connected to the peer, so the kernel delivers all further
+// datagrams of that flow straight to it by their 4-tuple, and each peer can be served from its own thread
+// without demultiplexing in userspace. On Linux, the reuseport group is steered so that datagrams from
+// unknown peers always reach the listener, never a not-yet-connected peer socket.
+//
+// In the short window before the peer socket is connected, further datagrams from the same peer may still reach
+// the listener. Those are discarded by `accept`, like any lost datagram. Once the peer socket is closed,
+// `release` must be called so that the next datagram from the peer is accepted again.
+//
+// Only supported on platforms with SO_REUSEPORT, `bind` fails with `Unimplemented` on others (Windows).
+// The listener itself is not thread safe, `accept` and `release` should be called from one thread.
+class UdpListener {
+public:
+    // Binds the listener socket. If the port is 0, a random one is chosen and used for all peer sockets.
+    static NetResult<UdpListener> bind(const SocketAddress& address);
+
+    UdpListener(UdpListener&& other) noexcept = default;
+    UdpListener& operator=(UdpListener&& other) noexcept = default;
+
+    // Waits for a datagram from a new peer, and returns a socket connected to it.
+    // The datagram itself is written to `buffer`, if it is too small excess data is discarded.
+    NetResult<UdpAccepted> accept(void* buffer, size_t size);
+
+    // Forgets the peer, after its socket was closed. Returns false if the peer was not accepted.
+    bool release(const SocketAddress& peer);
+
+    // Amount of peers accepted and not released yet
+    size_t peerCount() const;
+
+    SocketAddress localAddress() const;
+
+    // Returns the listener socket, e.g. for polling or setting options
+    UdpSocket& socket();
+
+private:
+    UdpSocket m_socket;
+    SocketAddress m_localAddress;
+    AddressSet<CompactSocketAddress> m_peers;
+
+    UdpListener(UdpSocket socket, const SocketAddress& localAddress);
+
+    NetResult<UdpSocket> connectPeer(const SocketAddress& peer);
+};
+
+} // namespace qsox
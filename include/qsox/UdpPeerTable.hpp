@@ -0,0 +1,49 @@
+#pragma once
+
+#include "AddressMap.hpp"
+#include "UdpSocket.hpp"
+#include <utility>
+#include <vector>
+
+namespace qsox {
+
+// Assigns small, dense IDs to UDP peers, so that per-peer state can be kept in plain arrays indexed by the ID.
+// Peers are keyed by the native address filled by `UdpSocket::recvFrom(..., UdpDestination&)`, so finding the peer
+// of an incoming datagram is a single hash table probe, without constructing a SocketAddress.
+// IDs of removed peers are reused by peers added later.
+class UdpPeerTable {
+public:
+    static constexpr uint32_t InvalidId = UINT32_MAX;
+
+    // Returns the ID of the peer, assigning a new one if the peer is not in the table yet.
+    // The second value is true if the peer was added.
+    std::pair<uint32_t, bool> intern(const UdpDestination& peer);
+
+    // Returns the ID of the peer, or `InvalidId` if it is not in the table
+    uint32_t find(const UdpDestination& peer) const;
+
+    // Removes the peer, returns false if the ID was not in use
+    bool remove(uint32_t id);
+
+    bool contains(uint32_t id) const;
+
+    // Returns the address of the peer, which can be passed to `UdpSocket::sendTo` directly.
+    // The ID must be in use.
+    const UdpDestination& destination(uint32_t id) const;
+
+    // Returns the amount of peers in the table
+    size_t size() const;
+
+    // Returns a value larger than every ID in use, for sizing per-peer arrays
+    size_t idLimit() const;
+
+    void reserve(size_t count);
+    void clear();
+
+private:
+    AddressMap<CompactSocketAddress, uint32_t> m_ids;
+    std::vector<UdpDestination> m_peers; // indexed by ID, entries of removed peers have a size of 0
+    std::vector<uint32_t> m_freeIds;
+};
+
+} // namespace qsox
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "CompactSocketAddress.hpp"
+#include "TokenBucket.hpp"
+#include "UdpSocket.hpp"
+#include <memory>
+
+namespace qsox {
+
+struct UdpRateLimiterOptions {
+    // Sustained rate (per second) and burst size allowed for each source, in datagrams by default,
+    // or in whatever unit the costs passed to `allow` are in
+    uint64_t rate = 1000;
+    uint64_t burst = 1000;
+    // Sources are limited per prefix, e.g. with the default /64 all addresses of an IPv6 subnet share a bucket
+    uint8_t ipv4Prefix = 32;
+    uint8_t ipv6Prefix = 64;
+    // Maximum amount of sources tracked at once, the least recently seen ones are evicted (and forgotten) beyond that
+    size_t maxSources = 65536;
+    // Amount of independently locked shards, rounded up to a power of two
+    size_t shards = 16;
+};
+
+struct UdpRateLimiterStats {
+    // Datagrams (or calls to `allow`) that were let through
+    uint64_t allowed = 0;
+    // Datagrams that were limited
+    uint64_t limited = 0;
+    // Sources evicted to make room for new ones
+    uint64_t evicted = 0;
+    // Sources currently tracked
+    size_t sources = 0;
+};
+
+// Per-source token bucket rate limiter, for discarding floods right after receiving, before doing any processing.
+// IPv4-mapped addresses are limited as IPv4, so dual stack sockets share buckets with IPv4 ones.
+// The table is split into shards with their own lock, each shard keeps its sources in an LRU list
+// and has a fixed capacity, so memory use is bounded. Thread safe.
+class UdpRateLimiter {
+public:
+    using Clock = TokenBucket::Clock;
+    using TimePoint = TokenBucket::TimePoint;
+
+    explicit UdpRateLimiter(const UdpRateLimiterOptions& options = {});
+    ~UdpRateLimiter();
+
+    UdpRateLimiter(const UdpRateLimiter&) = delete;
+    UdpRateLimiter& operator=(const UdpRateLimiter&) = delete;
+
+    // Takes `cost` tokens from the bucket of the source, returns false if the source is over its limit
+    bool allow(const IpAddress& source, uint64_t cost = 1, TimePoint now = Clock::now());
+    bool allow(const UdpDestination& source, uint64_t cost = 1, TimePoint now = Clock::now());
+
+    // Drops the datagrams of limited sources from a batch filled by `UdpSocket::recvBatch`.
+    // The buffers of allowed datagrams are moved to the front (by swapping, so no buffer is lost, but their order
+    // in the array changes), and their amount is returned.
+    size_t filter(UdpBatchBuffer* buffers, size_t count, TimePoint now = Clock::now());
+
+    // Same as `UdpSocket::recvFrom`, but silently discards datagrams from limited sources
+    NetResult<size_t> recvFrom(UdpSocket& socket, void* buffer, size_t size, UdpDestination& sender);
+
+    // Same as `UdpSocket::recvBatch` followed by `filter`, receiving again if every datagram was limited
+    NetResult<size_t> recvBatch(UdpSocket& socket, UdpBatchBuffer* buffers, size_t count);
+
+    // Returns the counters, summed over all shards
+    UdpRateLimiterStats stats() const;
+
+    // Forgets every source (the counters are kept)
+    void clear();
+
+private:
+    struct Shard;
+
+    std::unique_ptr<Shard[]> m_shards;
+    size_t m_shardCount;
+    int m_shardShift;
+    int64_t m_tolerance; // time it takes to refill a whole burst, in nanoseconds
+    UdpRateLimiterOptions m_options;
+
+    CompactSocketAddress keyFor(const IpAddress& source) const;
+    int64_t costFor(uint64_t cost) const;
+};
+
+} // namespace qsox
@@ -1,15 +1,111 @@
 #pragma once
 
 #include "BaseSocket.hpp"
+#include "CompactSocketAddress.hpp"
 #include <stddef.h>
 #include <stdint.h>
 
 namespace qsox {
 
+// An address in the native sockaddr form, either prepared for sending with `UdpSocket::prepareDestination`,
+// or filled with the sender of a datagram by `UdpSocket::recvFrom`.
+// Sending to it skips the address conversion, which matters when sending to the same peers repeatedly,
+// and a received sender can be replied to directly.
+class UdpDestination {
+public:
+    // Size of the largest native address (sockaddr_in6)
+    static constexpr size_t MaxNativeSize = 28;
+
+    UdpDestination() = default;
+
+    // Returns the address this destination was prepared from
+    SocketAddress address() const;
+
+    // Same as `address`, but converts straight from the native form.
+    // IPv4-mapped addresses are returned as IPv4, so a peer has the same key whether it was received or prepared.
+    CompactSocketAddress compactAddress() const;
+
+private:
+    friend class UdpSocket;
+    friend class UdpPeerTable;
+
+    alignas(8) uint8_t m_storage[MaxNativeSize] = {};
+    uint32_t m_size = 0;
+    bool m_mapped = false; // IPv4 address converted into an IPv4-mapped IPv6 one
+};
+
+// A single datagram for `UdpSocket::sendToBatch`
+struct UdpBatchMessage {
+    const void* data;
+    size_t size;
+    const UdpDestination* destination;
+    // Departure time, see `UdpSocket::sendAt`. Zero sends the datagram right away.
+    std::chrono::nanoseconds txTime{0};
+};
+
+// A single receive buffer for `UdpSocket::recvBatch`
+struct UdpBatchBuffer {
+    void* data;
+    size_t size;
+    // Filled on receive: size of the datagram (excess data beyond `size` is discarded) and its sender
+    size_t received = 0;
+    UdpDestination sender;
+};
+
+// Clock used for the departure times given to `UdpSocket::sendAt`, see `UdpSocket::enableTxTime`
+enum class TxTimeClock {
+    // CLOCK_MONOTONIC, the same clock as `std::chrono::steady_clock` on Linux. Required by the fq qdisc.
+    Monotonic,
+    // CLOCK_TAI, required by the etf qdisc
+    Tai,
+};
+
+// Path MTU discovery mode, see `UdpSocket::setPathMtuDiscovery`
+enum class PathMtuDiscovery {
+    // Never set the Don't Fragment flag, datagrams larger than the path MTU get fragmented
+    Dont,
+    // Set the Don't Fragment flag once the path MTU is known, fragment until then (Linux default)
+    Want,
+    // Always set the Don't Fragment flag, sends larger than the known path MTU fail with `MessageTooLong`
+    Do,
+    // Set the Don't Fragment flag, but ignore the known path MTU, for probing larger sizes
+    Probe,
+};
+
+// Sender and destination of a received datagram, see `UdpSocket::enablePacketInfo`
+struct UdpReceiveInfo {
+    SocketAddress sender;
+    // Local address the datagram was sent to. On a wildcard socket, replies should be sent from this address.
+    IpAddress destination = Ipv4Address::UNSPECIFIED;
+    // Index of the interface the datagram arrived on
+    uint32_t interfaceIndex = 0;
+    // When the datagram was received, if timestamping is enabled (see `BaseSocket::enableTimestamping`)
+    PacketTimestamp timestamp;
+    // Total amount of datagrams the socket had dropped when this one was queued,
+    // if drop reporting is enabled (see `UdpSocket::enableDropReporting`)
+    uint32_t drops = 0;
+};
+
+// State of the socket queues, see `UdpSocket::stats`
+struct UdpSocketStats {
+    // Bytes waiting in the receive queue. On Linux this includes the kernel overhead of each datagram,
+    // and can be compared with `receiveBufferSize` to see how close the socket is to dropping datagrams.
+    size_t queuedBytes = 0;
+    // Bytes waiting in the send queue (Linux only)
+    size_t sendQueuedBytes = 0;
+    // Size of the receive buffer, as reported by the kernel
+    size_t receiveBufferSize = 0;
+    // Total amount of datagrams dropped because the receive buffer was full (or rejected by an attached filter).
+    // Always 0 outside of Linux, where drop reporting is not supported.
+    uint64_t drops = 0;
+};
+
 class UdpSocket : public BaseSocket {
 public:
-    // Creates a new UDP socket, binding to the given address
-    static NetResult<UdpSocket> bind(const SocketAddress& address);
+    // Creates a new UDP socket, binding to the given address.
+    // If `reusePort` is true, SO_REUSEPORT is set, allowing multiple sockets to bind to the same address
+    // (not supported on Windows, fails with `Unimplemented` there).
+    static NetResult<UdpSocket> bind(const SocketAddress& address, bool reusePort = false);
     // Creates a new UDP socket, binding to 0.0.0.0 and a random port
     static NetResult<UdpSocket> bindAny(bool ipv6 = true);
 
@@ -24,8 +120,35 @@ public:
     NetResult<void> disconnect();
 
     // Sends a datagram to the specified address. Returns the number of bytes sent.
+    // A `MessageTooLong` error carries an MTU of 0, as the path MTU is only known on connected sockets,
+    // unless error reporting is enabled with `setPathMtuDiscovery`.
     NetResult<size_t> sendTo(const void* buffer, size_t size, const SocketAddress& destination);
 
+    // Converts the address into the native form used by this socket, for use with the `sendTo` overload below.
+    // The result is only valid for sockets of the same address family as this one.
+    UdpDestination prepareDestination(const SocketAddress& address) const;
+
+    // Sends a datagram to a prepared destination. Returns the number of bytes sent.
+    NetResult<size_t> sendTo(const void* buffer, size_t size, const UdpDestination& destination);
+
+    // Sends multiple datagrams, using as few syscalls as possible (sendmmsg on Linux, one sendto per datagram elsewhere).
+    // Returns the amount of datagrams that were sent, which is less than `count` if sending stopped early
+    // (e.g. the send buffer is full on a non-blocking socket). Fails only if no datagram could be sent.
+    NetResult<size_t> sendToBatch(const UdpBatchMessage* messages, size_t count);
+
+    // Enables SO_TXTIME, which lets `sendAt` (and `sendToBatch`) give every datagram a departure time.
+    // The kernel holds the datagrams until then, which needs the fq or etf qdisc on the outgoing interface;
+    // without one of them departure times are ignored. For a per-socket rate limit, see `setMaxPacingRate`.
+    // If `reportErrors` is true, datagrams dropped for missing their departure time are reported on the error queue.
+    // Only supported on Linux, fails with `Unimplemented` on other platforms.
+    NetResult<> enableTxTime(TxTimeClock clock = TxTimeClock::Monotonic, bool reportErrors = false);
+
+    // Sends a datagram that leaves no earlier than `txTime`, given on the clock passed to `enableTxTime`
+    // (for the monotonic clock, e.g. `TokenBucket::reserve(...).time_since_epoch()`).
+    // Only supported on Linux, fails with `Unimplemented` on other platforms. Returns the number of bytes sent.
+    NetResult<size_t> sendAt(const void* buffer, size_t size, const SocketAddress& destination, std::chrono::nanoseconds txTime);
+    NetResult<size_t> sendAt(const void* buffer, size_t size, const UdpDestination& destination, std::chrono::nanoseconds txTime);
+
     // Sends a datagram to the connected address. Returns the number of bytes sent.
     // Will fail if the socket is not connected.
     NetResult<size_t> send(const void* buffer, size_t size);
@@ -42,6 +165,79 @@ public:
     // On success, returns the number of bytes received.
     NetResult<size_t> recvFrom(void* buffer, size_t size, SocketAddressV6& sender);
 
+    // Receives a single datagram from the socket, storing the sender in its native form without converting it.
+    // On success, returns the number of bytes received.
+    NetResult<size_t> recvFrom(void* buffer, size_t size, UdpDestination& sender);
+
+    // Receives multiple datagrams, blocking only until the first one arrives, and then taking whatever else is queued
+    // (recvmmsg on Linux, non-blocking receives elsewhere). Returns the amount of buffers filled.
+    NetResult<size_t> recvBatch(UdpBatchBuffer* buffers, size_t count);
+
+    // Joins a multicast group (any-source multicast) on the given interface, 0 lets the system choose it.
+    // IPv4 groups can be joined on IPv6 sockets on Linux.
+    NetResult<> joinMulticast(const IpAddress& group, uint32_t interfaceIndex = 0);
+    NetResult<> leaveMulticast(const IpAddress& group, uint32_t interfaceIndex = 0);
+
+    // Joins a multicast group, only receiving datagrams sent by `source` (source-specific multicast)
+    NetResult<> joinMulticast(const IpAddress& group, const IpAddress& source, uint32_t interfaceIndex = 0);
+    NetResult<> leaveMulticast(const IpAddress& group, const IpAddress& source, uint32_t interfaceIndex = 0);
+
+    // Sets the interface outgoing multicast datagrams are sent from, 0 lets the system choose it.
+    // For IPv4 traffic, selecting an interface by index is only supported on Linux, elsewhere use the local address overload.
+    NetResult<> setMulticastInterface(uint32_t interfaceIndex);
+    // Sets the interface outgoing IPv4 multicast datagrams are sent from, by one of its addresses
+    NetResult<> setMulticastInterface(const Ipv4Address& localAddress);
+
+    // Sets whether multicast datagrams sent from this socket are looped back to local receivers (enabled by default)
+    NetResult<> setMulticastLoop(bool enable);
+
+    // Sets the TTL (hop limit) of outgoing multicast datagrams, 1 by default (which keeps them in the local network)
+    NetResult<> setMulticastTtl(uint8_t ttl);
+
+    // Sets the path MTU discovery mode (IP_MTU_DISCOVER, and IPV6_MTU_DISCOVER on IPv6 sockets).
+    // Outside of Linux only the Don't Fragment flag can be controlled: `Do` and `Probe` set it, `Dont` and `Want` clear it.
+    // If `reportErrors` is true, IP_RECVERR (and IPV6_RECVERR) is enabled as well, so that sends to any destination
+    // that exceed the MTU fail with an error carrying it, read back from the error queue. Note that this also makes
+    // ICMP errors (e.g. port unreachable) fail receives on unconnected sockets, and that the error queue is shared
+    // with `readTxTimestamps`. Only supported on Linux, fails with `Unimplemented` elsewhere.
+    NetResult<> setPathMtuDiscovery(PathMtuDiscovery mode, bool reportErrors = false);
+
+    // Returns the path MTU to the connected address as currently known by the kernel (IP_MTU/IPV6_MTU),
+    // including IP and UDP headers. Will fail if the socket is not connected. Not supported on macOS/BSD.
+    // Sends exceeding it with the Don't Fragment flag set fail with `MessageTooLong`, and the error carries the MTU.
+    NetResult<uint32_t> pathMtu() const;
+
+    // Returns the largest payload that fits into `pathMtu`, after the IP and UDP headers
+    NetResult<size_t> maxPayloadSize() const;
+
+    // Enables reporting the local destination address and interface of received datagrams (IP_PKTINFO/IPV6_RECVPKTINFO),
+    // see the `recvFrom` overload taking a `UdpReceiveInfo`. On IPv6 sockets this covers IPv4 traffic as well.
+    // Not supported on Windows, fails with `Unimplemented` there.
+    NetResult<> enablePacketInfo(bool enable = true);
+
+    // Receives a single datagram from the socket, along with its destination address, interface and timestamp.
+    // Without `enablePacketInfo`, the destination is left unspecified and the interface index is 0.
+    // On success, returns the number of bytes received.
+    NetResult<size_t> recvFrom(void* buffer, size_t size, UdpReceiveInfo& info);
+
+    // Enables SO_RXQ_OVFL, which makes receives with a `UdpReceiveInfo` report the drop counter of the socket.
+    // Only supported on Linux, fails with `Unimplemented` on other platforms.
+    NetResult<> enableDropReporting(bool enable = true);
+
+    // Returns the state of the socket queues and the drop counter. Uses SO_MEMINFO on Linux,
+    // elsewhere only the pending data (FIONREAD) and the receive buffer size are queried.
+    NetResult<UdpSocketStats> stats();
+
+    // Makes the socket double its receive buffer (up to `maxSize` bytes) whenever new drops are noticed,
+    // either by `stats` or by a receive with drop reporting enabled. Passing 0 disables auto-tuning.
+    void setReceiveBufferAutoTune(size_t maxSize);
+
+    // Sends a datagram from a specific local address, e.g. the destination of a received datagram when replying
+    // on a wildcard socket. A non-zero `interfaceIndex` also selects the outgoing interface.
+    // Not supported on Windows, fails with `Unimplemented` there. Returns the number of bytes sent.
+    NetResult<size_t> sendTo(const void* buffer, size_t size, const SocketAddress& destination, const IpAddress& source, uint32_t interfaceIndex = 0);
+    NetResult<size_t> sendTo(const void* buffer, size_t size, const UdpDestination& destination, const IpAddress& source, uint32_t interfaceIndex = 0);
+
     // Receives a single datagram from the connected address. If the buffer is too small, excess data is discarded.
     // On success returns the number of bytes received, will fail if the socket is not connected.
     NetResult<size_t> recv(void* buffer, size_t size);
@@ -61,6 +257,9 @@ public:
 
 private:
     bool ipv6 = false;
+    uint64_t m_lastDrops = 0;
+    size_t m_autoTuneMax = 0;
+    bool m_mtuErrors = false;
 
     UdpSocket(SockFd fd);
 
@@ -68,6 +267,12 @@ private:
     NetResult<size_t> _send(const void* buffer, size_t size, int flags);
     NetResult<size_t> _recv(void* buffer, size_t size, int flags);
     NetResult<size_t> _recvFrom(void* buffer, size_t size, SocketAddress& sender, int flags);
+    NetResult<size_t> _recvFrom(void* buffer, size_t size, UdpDestination& sender, int flags);
+    void _noteDrops(uint64_t drops);
+    // Returns the last error of a send, with the path MTU attached if it is `MessageTooLong`
+    Error _sendError() const;
+    // Dequeues the local `MessageTooLong` error queued by a failed send (needs IP_RECVERR), returns its MTU or 0
+    uint32_t _queuedMtu() const;
 };
 
 } // namespace qsox
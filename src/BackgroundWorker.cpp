@@ -0,0 +1,53 @@
+#include "BackgroundWorker.hpp"
+
+namespace qsox {
+
+BackgroundWorker::~BackgroundWorker() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_cv.notify_all();
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void BackgroundWorker::submit(std::function<void()> task) {
+    {
+        std::lock_guard lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+
+        if (m_threads.empty()) {
+            for (size_t i = 0; i < m_threadCount; i++) {
+                m_threads.emplace_back([this] { this->run(); });
+            }
+        }
+    }
+
+    m_cv.notify_one();
+}
+
+void BackgroundWorker::run() {
+    std::unique_lock lock(m_mutex);
+
+    while (true) {
+        m_cv.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+
+        // tasks that are still pending on shutdown are discarded
+        if (m_stopping) {
+            return;
+        }
+
+        auto task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+} // namespace qsox
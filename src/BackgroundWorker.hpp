@@ -0,0 +1,36 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace qsox {
+
+// Background threads that run submitted tasks from a shared queue, in submission order.
+// With more than one thread a slow task only holds up its own thread, the others keep taking tasks from the queue.
+// The threads are only spawned once the first task is submitted, and are joined on destruction.
+class BackgroundWorker {
+public:
+    explicit BackgroundWorker(size_t threads = 1) : m_threadCount(threads ? threads : 1) {}
+    BackgroundWorker(const BackgroundWorker&) = delete;
+    BackgroundWorker& operator=(const BackgroundWorker&) = delete;
+
+    ~BackgroundWorker();
+
+    void submit(std::function<void()> task);
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::function<void()>> m_tasks;
+    std::vector<std::thread> m_threads;
+    size_t m_threadCount;
+    bool m_stopping = false;
+
+    void run();
+};
+
+} // namespace qsox
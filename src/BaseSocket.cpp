@@ -1,6 +1,7 @@
 #include <qsox/BaseSocket.hpp>
 #include "SocketUtil.hpp"
 #include <cassert>
+#include <limits.h>
 
 namespace qsox {
 
@@ -76,6 +77,80 @@ Error BaseSocket::getSocketError() const {
     return Error::fromOs(err);
 }
 
+NetResult<> BaseSocket::setReceiveBufferSize(size_t size) {
+#ifdef SO_RCVBUFFORCE
+    return this->_setBufferSize(SO_RCVBUF, SO_RCVBUFFORCE, size);
+#else
+    return this->_setBufferSize(SO_RCVBUF, -1, size);
+#endif
+}
+
+NetResult<size_t> BaseSocket::receiveBufferSize() const {
+    return this->_getBufferSize(SO_RCVBUF);
+}
+
+NetResult<> BaseSocket::setSendBufferSize(size_t size) {
+#ifdef SO_SNDBUFFORCE
+    return this->_setBufferSize(SO_SNDBUF, SO_SNDBUFFORCE, size);
+#else
+    return this->_setBufferSize(SO_SNDBUF, -1, size);
+#endif
+}
+
+NetResult<size_t> BaseSocket::sendBufferSize() const {
+    return this->_getBufferSize(SO_SNDBUF);
+}
+
+NetResult<> BaseSocket::setMaxPacingRate(uint64_t bytesPerSecond) {
+#ifdef SO_MAX_PACING_RATE
+    if (bytesPerSecond == 0) {
+        bytesPerSecond = UINT64_MAX;
+    }
+
+    // kernels before 4.20 only accept a 32-bit value
+    if (bytesPerSecond < UINT32_MAX) {
+        uint32_t value = static_cast<uint32_t>(bytesPerSecond);
+        return mapResult(setsockopt(m_fd, SOL_SOCKET, SO_MAX_PACING_RATE, &value, sizeof(value)));
+    }
+
+    return mapResult(setsockopt(m_fd, SOL_SOCKET, SO_MAX_PACING_RATE, &bytesPerSecond, sizeof(bytesPerSecond)));
+#else
+    return Err(Error::Unimplemented);
+#endif
+}
+
+NetResult<> BaseSocket::_setBufferSize(int kind, int forceKind, size_t size) {
+    int value = static_cast<int>(std::min<size_t>(size, INT_MAX / 2));
+
+    GEODE_UNWRAP(mapResult(setsockopt(m_fd, SOL_SOCKET, kind, reinterpret_cast<const char*>(&value), sizeof(value))));
+
+    if (forceKind == -1) {
+        return Ok();
+    }
+
+    // the limit (e.g. net.core.rmem_max) silently caps the size, retry with the forcing option if that happened.
+    // Linux doubles the stored value, so compare against half of it.
+    GEODE_UNWRAP_INTO(size_t actual, this->_getBufferSize(kind));
+
+    if (actual / 2 < static_cast<size_t>(value)) {
+        // fails with EPERM for unprivileged processes, in which case the capped size is kept
+        (void) setsockopt(m_fd, SOL_SOCKET, forceKind, reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    return Ok();
+}
+
+NetResult<size_t> BaseSocket::_getBufferSize(int kind) const {
+    int value = 0;
+    socklen_t len = sizeof(value);
+
+    if (getsockopt(m_fd, SOL_SOCKET, kind, reinterpret_cast<char*>(&value), &len) < 0) {
+        return Err(Error::lastOsError());
+    }
+
+    return Ok(static_cast<size_t>(value));
+}
+
 NetResult<> initSockets() {
     return startupSockets();
 }
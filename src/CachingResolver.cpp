@@ -0,0 +1,157 @@
+#include <qsox/CachingResolver.hpp>
+#include "BackgroundWorker.hpp"
+
+namespace qsox::resolver {
+
+CachingResolver::CachingResolver(CacheOptions options)
+    : m_options(options), m_worker(std::make_unique<BackgroundWorker>()) {}
+
+// defined here because BackgroundWorker is incomplete in the header
+CachingResolver::~CachingResolver() = default;
+
+CachingResolver& CachingResolver::global() {
+    static CachingResolver resolver;
+    return resolver;
+}
+
+Result<Ipv4Address> CachingResolver::resolveIpv4(const std::string& hostname) {
+    return this->lookup(hostname, Family::V4).map([](const IpAddress& addr) {
+        return addr.asV4();
+    });
+}
+
+Result<Ipv6Address> CachingResolver::resolveIpv6(const std::string& hostname) {
+    return this->lookup(hostname, Family::V6).map([](const IpAddress& addr) {
+        return addr.asV6();
+    });
+}
+
+Result<IpAddress> CachingResolver::resolve(const std::string& hostname) {
+    return this->lookup(hostname, Family::Any);
+}
+
+void CachingResolver::clear() {
+    std::lock_guard lock(m_mutex);
+
+    for (auto& entries : m_entries) {
+        entries.clear();
+    }
+}
+
+Result<IpAddress> CachingResolver::lookup(const std::string& hostname, Family family) {
+    {
+        std::lock_guard lock(m_mutex);
+
+        auto& entries = m_entries[static_cast<size_t>(family)];
+        auto it = entries.find(hostname);
+
+        if (it != entries.end()) {
+            Entry& entry = it->second;
+            auto age = Clock::now() - entry.resolvedAt;
+            entry.hits++;
+
+            if (age < m_options.ttl) {
+                // fresh, refresh ahead of time if the entry is hot
+                if (age >= m_options.ttl * m_options.refreshAhead && entry.hits >= m_options.hotThreshold) {
+                    this->scheduleRefresh(hostname, family, entry);
+                }
+
+                return Ok(entry.address);
+            } else if (age < m_options.ttl + m_options.maxStale) {
+                // stale but within the allowed window, serve it while it's being refreshed
+                this->scheduleRefresh(hostname, family, entry);
+                return Ok(entry.address);
+            }
+
+            // too stale to be served, resolve synchronously below
+        }
+    }
+
+    auto result = this->resolveUncached(hostname, family);
+    if (result) {
+        this->store(hostname, family, *result);
+    }
+
+    return result;
+}
+
+Result<IpAddress> CachingResolver::resolveUncached(const std::string& hostname, Family family) {
+    switch (family) {
+        case Family::V4:
+            return resolver::resolveIpv4(hostname, m_options.timeoutMs).map([](const Ipv4Address& addr) {
+                return IpAddress(addr);
+            });
+        case Family::V6:
+            return resolver::resolveIpv6(hostname, m_options.timeoutMs).map([](const Ipv6Address& addr) {
+                return IpAddress(addr);
+            });
+        case Family::Any:
+            return resolver::resolve(hostname, m_options.timeoutMs);
+    }
+
+    qsox::unreachable();
+}
+
+void CachingResolver::store(const std::string& hostname, Family family, const IpAddress& address) {
+    std::lock_guard lock(m_mutex);
+
+    auto& entries = m_entries[static_cast<size_t>(family)];
+    auto now = Clock::now();
+
+    auto it = entries.find(hostname);
+    if (it != entries.end()) {
+        // hits are counted per TTL period, so that only hostnames that are still in use stay hot
+        it->second.address = address;
+        it->second.resolvedAt = now;
+        it->second.hits = 0;
+        it->second.refreshing = false;
+        return;
+    }
+
+    if (entries.size() >= m_options.maxEntries) {
+        // first drop everything that can no longer be served
+        std::erase_if(entries, [&](const auto& pair) {
+            return !pair.second.refreshing && now - pair.second.resolvedAt >= m_options.ttl + m_options.maxStale;
+        });
+
+        // still full, evict an arbitrary entry
+        if (entries.size() >= m_options.maxEntries && !entries.empty()) {
+            entries.erase(entries.begin());
+        }
+    }
+
+    entries.emplace(hostname, Entry {
+        .address = address,
+        .resolvedAt = now,
+        .hits = 1,
+        .refreshing = false,
+    });
+}
+
+void CachingResolver::scheduleRefresh(const std::string& hostname, Family family, Entry& entry) {
+    // must be called with the mutex locked
+    if (entry.refreshing) {
+        return;
+    }
+
+    entry.refreshing = true;
+
+    m_worker->submit([this, hostname, family] {
+        auto result = this->resolveUncached(hostname, family);
+
+        if (result) {
+            this->store(hostname, family, *result);
+            return;
+        }
+
+        // keep serving the old address until the stale window passes, a later lookup will retry
+        std::lock_guard lock(m_mutex);
+        auto& entries = m_entries[static_cast<size_t>(family)];
+        auto it = entries.find(hostname);
+        if (it != entries.end()) {
+            it->second.refreshing = false;
+        }
+    });
+}
+
+} // namespace qsox::resolver
@@ -0,0 +1,62 @@
+#include <qsox/CompactSocketAddress.hpp>
+
+#ifdef _WIN32
+# include <ws2tcpip.h>
+#else
+# include <sys/socket.h>
+# include <netinet/in.h>
+#endif
+
+namespace qsox {
+
+std::optional<CompactSocketAddress> CompactSocketAddress::fromBytes(const uint8_t* bytes) {
+    if ((bytes[0] != 4 && bytes[0] != 6) || bytes[1] != 0) {
+        return std::nullopt;
+    }
+
+    // unused address bytes of IPv4 addresses must be zero, so that equal addresses have equal bytes
+    if (bytes[0] == 4) {
+        for (size_t i = 6; i < 18; i++) {
+            if (bytes[i] != 0) {
+                return std::nullopt;
+            }
+        }
+    }
+
+    CompactSocketAddress out;
+    memcpy(out.m_bytes, bytes, Size);
+    return out;
+}
+
+CompactSocketAddress CompactSocketAddress::fromSockAddr(const sockaddr& addr) {
+    CompactSocketAddress out;
+
+    // copy the address and port bytes as they are, both are in network byte order already
+    if (addr.sa_family == AF_INET) {
+        auto& addrV4 = reinterpret_cast<const sockaddr_in&>(addr);
+        memcpy(out.m_bytes + 2, &addrV4.sin_addr, 4);
+        memcpy(out.m_bytes + 18, &addrV4.sin_port, 2);
+    } else {
+        auto& addrV6 = reinterpret_cast<const sockaddr_in6&>(addr);
+        out.m_bytes[0] = 6;
+        memcpy(out.m_bytes + 2, &addrV6.sin6_addr, 16);
+        memcpy(out.m_bytes + 18, &addrV6.sin6_port, 2);
+    }
+
+    return out;
+}
+
+int CompactSocketAddress::family() const {
+    return this->isV4() ? AF_INET : AF_INET6;
+}
+
+std::string CompactSocketAddress::toString() const {
+    char buf[MaxStringLength];
+    return std::string(buf, this->toChars(buf));
+}
+
+char* CompactSocketAddress::toChars(char* buf) const {
+    return this->toSocketAddress().toChars(buf);
+}
+
+} // namespace qsox
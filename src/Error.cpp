@@ -12,6 +12,12 @@ Error Error::fromOs(int osCode) {
     return Error(Code::Other, osCode);
 }
 
+Error Error::messageTooLong(uint32_t mtu) {
+    Error err{Code::MessageTooLong};
+    err.m_mtu = mtu;
+    return err;
+}
+
 Error::Code Error::code() const {
     return m_code;
 }
@@ -24,6 +30,10 @@ int Error::osCode() const {
     return m_osCode;
 }
 
+uint32_t Error::mtu() const {
+    return m_mtu;
+}
+
 bool Error::operator==(const Error& other) const {
     return m_code == other.m_code && m_osCode == other.m_osCode;
 }
@@ -61,6 +71,10 @@ std::string Error::message() const {
         case Code::NotASocket:
             return "Attempting to perform operation on a non-socket";
         case Code::MessageTooLong:
+            if (m_mtu != 0) {
+                return fmt::format("Message too long (path MTU {})", m_mtu);
+            }
+
             return "Message too long";
         case Code::AccessDenied:
             return "Access denied";
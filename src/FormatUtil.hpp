@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <stdint.h>
+#include <string.h>
+
+// Table driven number formatting used by the address toChars methods.
+// None of these write a null terminator, and all of them return the pointer past the last written character.
+
+namespace qsox::fmtutil {
+
+// Decimal representation of every byte value, first byte is the length
+constexpr auto DecimalTable = [] {
+    std::array<std::array<char, 4>, 256> table{};
+
+    for (int i = 0; i < 256; i++) {
+        auto& entry = table[i];
+
+        if (i >= 100) {
+            entry = {3, char('0' + i / 100), char('0' + i / 10 % 10), char('0' + i % 10)};
+        } else if (i >= 10) {
+            entry = {2, char('0' + i / 10), char('0' + i % 10), 0};
+        } else {
+            entry = {1, char('0' + i), 0, 0};
+        }
+    }
+
+    return table;
+}();
+
+constexpr char HexDigits[] = "0123456789abcdef";
+
+inline char* writeDecimal(char* out, uint8_t value) {
+    const auto& entry = DecimalTable[value];
+    memcpy(out, entry.data() + 1, 3);
+    return out + entry[0];
+}
+
+inline char* writeDecimal(char* out, uint16_t value) {
+    // split into a leading part (0-6) and the last 4 digits
+    char digits[5];
+    uint32_t v = value;
+
+    digits[4] = static_cast<char>('0' + v % 10); v /= 10;
+    digits[3] = static_cast<char>('0' + v % 10); v /= 10;
+    digits[2] = static_cast<char>('0' + v % 10); v /= 10;
+    digits[1] = static_cast<char>('0' + v % 10); v /= 10;
+    digits[0] = static_cast<char>('0' + v);
+
+    size_t len = value >= 10000 ? 5 : value >= 1000 ? 4 : value >= 100 ? 3 : value >= 10 ? 2 : 1;
+    memcpy(out, digits + 5 - len, len);
+    return out + len;
+}
+
+// Writes a 16-bit value in lowercase hex without leading zeros
+inline char* writeHex(char* out, uint16_t value) {
+    size_t nibbles = value == 0 ? 1 : (std::bit_width(value) + 3) / 4;
+
+    for (size_t i = nibbles; i > 0; i--) {
+        *out++ = HexDigits[(value >> ((i - 1) * 4)) & 0xf];
+    }
+
+    return out;
+}
+
+} // namespace qsox::fmtutil
@@ -0,0 +1,182 @@
+#include "HostsFile.hpp"
+#include <qsox/Resolver.hpp>
+#include <fstream>
+#include <sstream>
+#include <stdlib.h>
+
+namespace qsox::resolver {
+
+static std::filesystem::path hostsFilePath() {
+#ifdef _WIN32
+    const char* root = getenv("SystemRoot");
+    std::filesystem::path base = root ? root : "C:\\Windows";
+    return base / "System32" / "drivers" / "etc" / "hosts";
+#else
+    return "/etc/hosts";
+#endif
+}
+
+static constexpr char asciiLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+HostsFile::HostsFile() : m_path(hostsFilePath()) {}
+
+HostsFile& HostsFile::get() {
+    static HostsFile hosts;
+    return hosts;
+}
+
+std::optional<Ipv4Address> HostsFile::lookupIpv4(std::string_view hostname) {
+    return this->find(hostname, [](const Entry& entry) { return entry.v4; });
+}
+
+std::optional<Ipv6Address> HostsFile::lookupIpv6(std::string_view hostname) {
+    return this->find(hostname, [](const Entry& entry) { return entry.v6; });
+}
+
+template <typename F>
+auto HostsFile::find(std::string_view hostname, F&& func) -> decltype(func(std::declval<const Entry&>())) {
+    // hostnames are limited to 253 characters, anything longer can't be in the file
+    char lowered[256];
+    if (hostname.empty() || hostname.size() > sizeof(lowered)) {
+        return std::nullopt;
+    }
+
+    for (size_t i = 0; i < hostname.size(); i++) {
+        lowered[i] = asciiLower(hostname[i]);
+    }
+
+    this->reloadIfChanged();
+
+    std::shared_lock lock(m_mutex);
+
+    auto it = m_entries.find(std::string_view{lowered, hostname.size()});
+    if (it == m_entries.end()) {
+        return std::nullopt;
+    }
+
+    return func(it->second);
+}
+
+void HostsFile::reloadIfChanged() {
+    using Clock = std::chrono::steady_clock;
+
+    int64_t now = Clock::now().time_since_epoch().count();
+    int64_t nextCheck = m_nextCheck.load(std::memory_order_relaxed);
+
+    if (now < nextCheck) {
+        return;
+    }
+
+    // only one thread gets to perform the check, the rest keep using the current index
+    int64_t interval = std::chrono::duration_cast<Clock::duration>(RecheckInterval).count();
+    if (!m_nextCheck.compare_exchange_strong(nextCheck, now + interval)) {
+        return;
+    }
+
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(m_path, ec);
+
+    if (ec) {
+        // file is missing or unreadable, don't answer anything from a stale index
+        std::unique_lock lock(m_mutex);
+        m_entries.clear();
+        m_mtime = {};
+        return;
+    }
+
+    if (mtime == m_mtime) {
+        return;
+    }
+
+    std::ifstream file(m_path, std::ios::binary);
+    if (!file) {
+        return;
+    }
+
+    std::stringstream ss;
+    ss << file.rdbuf();
+
+    std::unique_lock lock(m_mutex);
+    m_mtime = mtime;
+    this->parse(ss.str());
+}
+
+void HostsFile::parse(std::string_view contents) {
+    // must be called with the mutex locked
+    m_entries.clear();
+
+    while (!contents.empty()) {
+        size_t lineEnd = contents.find('\n');
+        std::string_view line = contents.substr(0, lineEnd);
+        contents.remove_prefix(lineEnd == std::string_view::npos ? contents.size() : lineEnd + 1);
+
+        // strip comments
+        size_t comment = line.find('#');
+        if (comment != std::string_view::npos) {
+            line = line.substr(0, comment);
+        }
+
+        // split into whitespace separated fields, first one is the address and the rest are names
+        auto nextField = [&]() -> std::string_view {
+            while (!line.empty() && isSpace(line.front())) {
+                line.remove_prefix(1);
+            }
+
+            size_t len = 0;
+            while (len < line.size() && !isSpace(line[len])) {
+                len++;
+            }
+
+            auto field = line.substr(0, len);
+            line.remove_prefix(len);
+            return field;
+        };
+
+        auto addressStr = nextField();
+        if (addressStr.empty()) {
+            continue;
+        }
+
+        std::optional<Ipv4Address> v4;
+        std::optional<Ipv6Address> v6;
+
+        if (auto addr = Ipv4Address::parse(addressStr)) {
+            v4 = *addr;
+        } else if (auto addr = Ipv6Address::parse(addressStr)) {
+            v6 = *addr;
+        } else {
+            continue;
+        }
+
+        for (auto name = nextField(); !name.empty(); name = nextField()) {
+            std::string key(name);
+            for (char& c : key) {
+                c = asciiLower(c);
+            }
+
+            // like the system resolver, the first line that mentions a name wins
+            auto& entry = m_entries[std::move(key)];
+            if (v4 && !entry.v4) {
+                entry.v4 = v4;
+            } else if (v6 && !entry.v6) {
+                entry.v6 = v6;
+            }
+        }
+    }
+}
+
+std::optional<Ipv4Address> lookupHostsIpv4(std::string_view hostname) {
+    return HostsFile::get().lookupIpv4(hostname);
+}
+
+std::optional<Ipv6Address> lookupHostsIpv6(std::string_view hostname) {
+    return HostsFile::get().lookupIpv6(hostname);
+}
+
+} // namespace qsox::resolver
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <qsox/Ipv4Address.hpp>
+#include <qsox/Ipv6Address.hpp>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace qsox::resolver {
+
+// In-memory index of the system hosts file.
+// The file is parsed on first use, and is re-parsed whenever its modification time changes.
+// To avoid a stat() on every lookup, the modification time is checked at most once per `RecheckInterval`.
+class HostsFile {
+public:
+    static constexpr auto RecheckInterval = std::chrono::seconds(1);
+
+    static HostsFile& get();
+
+    std::optional<Ipv4Address> lookupIpv4(std::string_view hostname);
+    std::optional<Ipv6Address> lookupIpv6(std::string_view hostname);
+
+private:
+    struct Entry {
+        std::optional<Ipv4Address> v4;
+        std::optional<Ipv6Address> v6;
+    };
+
+    struct StringHash {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view str) const {
+            return std::hash<std::string_view>{}(str);
+        }
+    };
+
+    std::shared_mutex m_mutex;
+    std::unordered_map<std::string, Entry, StringHash, std::equal_to<>> m_entries;
+    std::filesystem::path m_path;
+    std::filesystem::file_time_type m_mtime{};
+    std::atomic<int64_t> m_nextCheck{0};
+
+    HostsFile();
+
+    void reloadIfChanged();
+    void parse(std::string_view contents);
+
+    template <typename F>
+    auto find(std::string_view hostname, F&& func) -> decltype(func(std::declval<const Entry&>()));
+};
+
+} // namespace qsox::resolver
@@ -15,7 +15,11 @@ std::string IpAddress::toString() const {
     return this->isV6() ? this->asV6().toString() : this->asV4().toString();
 }
 
-Result<IpAddress, void> IpAddress::parse(const std::string& str) {
+char* IpAddress::toChars(char* buf) const {
+    return this->isV6() ? this->asV6().toChars(buf) : this->asV4().toChars(buf);
+}
+
+Result<IpAddress, void> IpAddress::parse(std::string_view str) {
     // early skip v4 if the address is too long or too short
     if (str.size() < 7 || str.size() > 15) {
         if (auto v6 = Ipv6Address::parse(str)) {
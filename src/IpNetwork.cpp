@@ -0,0 +1,110 @@
+#include <qsox/IpNetwork.hpp>
+#include "FormatUtil.hpp"
+#include <charconv>
+
+namespace qsox {
+
+std::string_view IpNetworkParseError::message() const {
+    switch (m_code) {
+        case InvalidAddress:
+            return "Invalid network address";
+        case MissingPrefix:
+            return "Missing prefix length";
+        case InvalidPrefix:
+            return "Invalid prefix length";
+    }
+
+    qsox::unreachable();
+}
+
+// Splits 'addr/n' into the address part and the prefix length, checking the prefix against `maxPrefix`
+static Result<std::pair<std::string_view, uint8_t>, IpNetworkParseError> splitNetwork(std::string_view str, uint8_t maxPrefix) {
+    auto slashPos = str.rfind('/');
+    if (slashPos == std::string_view::npos || slashPos == 0) {
+        return Err(IpNetworkParseError::MissingPrefix);
+    }
+
+    std::string_view prefixPart = str.substr(slashPos + 1);
+
+    uint8_t prefix = 0;
+    auto res = std::from_chars(prefixPart.data(), prefixPart.data() + prefixPart.size(), prefix);
+    if (prefixPart.empty() || res.ec != std::errc() || res.ptr != prefixPart.data() + prefixPart.size() || prefix > maxPrefix) {
+        return Err(IpNetworkParseError::InvalidPrefix);
+    }
+
+    return Ok(std::make_pair(str.substr(0, slashPos), prefix));
+}
+
+// Ipv4Network
+
+Result<Ipv4Network, IpNetworkParseError> Ipv4Network::parse(std::string_view str) {
+    GEODE_UNWRAP_INTO(auto parts, splitNetwork(str, MaxPrefixLength));
+
+    auto addr = Ipv4Address::parse(parts.first);
+    if (!addr) {
+        return Err(IpNetworkParseError::InvalidAddress);
+    }
+
+    return Ok(Ipv4Network(*addr, parts.second));
+}
+
+std::string Ipv4Network::toString() const {
+    char buf[MaxStringLength];
+    return std::string(buf, this->toChars(buf));
+}
+
+char* Ipv4Network::toChars(char* buf) const {
+    buf = m_address.toChars(buf);
+    *buf++ = '/';
+
+    // the uint8_t overload always writes 3 characters, which could overflow right after a maximum length address
+    return fmtutil::writeDecimal(buf, static_cast<uint16_t>(m_prefix));
+}
+
+// Ipv6Network
+
+Result<Ipv6Network, IpNetworkParseError> Ipv6Network::parse(std::string_view str) {
+    GEODE_UNWRAP_INTO(auto parts, splitNetwork(str, MaxPrefixLength));
+
+    auto addr = Ipv6Address::parseBare(parts.first);
+    if (!addr) {
+        return Err(IpNetworkParseError::InvalidAddress);
+    }
+
+    return Ok(Ipv6Network(*addr, parts.second));
+}
+
+std::string Ipv6Network::toString() const {
+    char buf[MaxStringLength];
+    return std::string(buf, this->toChars(buf));
+}
+
+char* Ipv6Network::toChars(char* buf) const {
+    buf = m_address.toChars(buf);
+    *buf++ = '/';
+    return fmtutil::writeDecimal(buf, static_cast<uint16_t>(m_prefix));
+}
+
+// IpNetwork
+
+Result<IpNetwork, IpNetworkParseError> IpNetwork::parse(std::string_view str) {
+    // a '.' before any ':' means it can only be an IPv4 network
+    size_t colon = str.find(':');
+    size_t dot = str.find('.');
+
+    if (colon == std::string_view::npos || (dot != std::string_view::npos && dot < colon)) {
+        return Ipv4Network::parse(str).map([](const Ipv4Network& net) { return IpNetwork(net); });
+    }
+
+    return Ipv6Network::parse(str).map([](const Ipv6Network& net) { return IpNetwork(net); });
+}
+
+std::string IpNetwork::toString() const {
+    return this->isV6() ? this->asV6().toString() : this->asV4().toString();
+}
+
+char* IpNetwork::toChars(char* buf) const {
+    return this->isV6() ? this->asV6().toChars(buf) : this->asV4().toChars(buf);
+}
+
+} // namespace qsox
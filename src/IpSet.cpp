@@ -0,0 +1,445 @@
+#include <qsox/IpSet.hpp>
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <bit>
+#include <fstream>
+#include <tuple>
+#include <string.h>
+
+namespace qsox {
+
+std::string_view IpSetError::message() const {
+    switch (m_code) {
+        case OpenFailed:
+            return "Failed to open the IP set file";
+        case WriteFailed:
+            return "Failed to write the IP set file";
+        case InvalidFormat:
+            return "Not a valid IP set file";
+        case UnsupportedVersion:
+            return "Unsupported IP set file version";
+        case ChecksumMismatch:
+            return "IP set file is corrupted (checksum mismatch)";
+    }
+
+    qsox::unreachable();
+}
+
+// Integers are written in host byte order, which is little-endian on every platform qsox supports.
+static_assert(std::endian::native == std::endian::little, "the IP set file format is little-endian");
+
+static constexpr char IpSetMagic[8] = {'Q', 'S', 'O', 'X', 'I', 'P', 'S', 'T'};
+static constexpr uint32_t IpSetVersion = 1;
+
+// Entries in the IPv4 index, one per 16-bit prefix plus the end
+static constexpr size_t V4IndexSize = (size_t(1) << 16) + 1;
+
+struct IpSetHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t fileSize;
+    uint64_t v4Count;
+    uint64_t v4Offset;
+    uint64_t v6Count;
+    uint64_t v6Offset;
+    uint64_t checksum;
+};
+
+static_assert(sizeof(IpSetHeader) == 64);
+
+static size_t alignTo8(size_t n) {
+    return (n + 7) & ~size_t(7);
+}
+
+static size_t v4SectionSize(size_t count) {
+    return alignTo8(count * 2 * sizeof(uint32_t) + V4IndexSize * sizeof(uint32_t));
+}
+
+static size_t v6SectionSize(size_t count) {
+    return count * 4 * sizeof(uint64_t);
+}
+
+// Checksum over 8-byte words, `size` must be a multiple of 8.
+// Not cryptographic, it only has to catch truncated or corrupted files, but it must be fast enough to run on startup.
+static uint64_t checksum(const uint8_t* data, size_t size) {
+    uint64_t h = 0x2d358dccaa6c78a5ull ^ size;
+
+    for (size_t i = 0; i < size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+
+        h ^= word * 0x9e3779b97f4a7c15ull;
+        h = std::rotl(h, 27) * 0xc2b2ae3d27d4eb4full;
+    }
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h;
+}
+
+static std::pair<uint64_t, uint64_t> toHalves(const Ipv6Address& addr) {
+    auto& o = addr.octets();
+    uint64_t hi = 0, lo = 0;
+
+    for (size_t i = 0; i < 8; i++) {
+        hi = hi << 8 | o[i];
+        lo = lo << 8 | o[i + 8];
+    }
+
+    return {hi, lo};
+}
+
+// IpSetBuilder
+
+void IpSetBuilder::add(const Ipv4Address& addr) {
+    this->addRange(addr, addr);
+}
+
+void IpSetBuilder::add(const Ipv6Address& addr) {
+    this->addRange(addr, addr);
+}
+
+void IpSetBuilder::add(const IpAddress& addr) {
+    if (addr.isV4()) {
+        this->add(addr.asV4());
+    } else {
+        this->add(addr.asV6());
+    }
+}
+
+void IpSetBuilder::add(const IpNetwork& network) {
+    if (network.isV4()) {
+        this->addRange(network.asV4().address(), network.asV4().broadcast());
+    } else {
+        this->addRange(network.asV6().address(), network.asV6().last());
+    }
+}
+
+void IpSetBuilder::addRange(const Ipv4Address& first, const Ipv4Address& last) {
+    if (first.toBits() <= last.toBits()) {
+        m_v4.emplace_back(first.toBits(), last.toBits());
+    }
+}
+
+void IpSetBuilder::addRange(const Ipv6Address& first, const Ipv6Address& last) {
+    auto [firstHi, firstLo] = toHalves(first);
+    auto [lastHi, lastLo] = toHalves(last);
+
+    if (std::pair(firstHi, firstLo) <= std::pair(lastHi, lastLo)) {
+        m_v6.push_back(Range6{firstHi, firstLo, lastHi, lastLo});
+    }
+}
+
+static std::string_view trim(std::string_view str) {
+    auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+
+    while (!str.empty() && isSpace(str.front())) {
+        str.remove_prefix(1);
+    }
+
+    while (!str.empty() && isSpace(str.back())) {
+        str.remove_suffix(1);
+    }
+
+    return str;
+}
+
+size_t IpSetBuilder::addText(std::string_view text) {
+    size_t failed = 0;
+
+    while (!text.empty()) {
+        size_t lineEnd = text.find('\n');
+        std::string_view line = text.substr(0, lineEnd);
+        text.remove_prefix(lineEnd == std::string_view::npos ? text.size() : lineEnd + 1);
+
+        size_t comment = line.find('#');
+        if (comment != std::string_view::npos) {
+            line = line.substr(0, comment);
+        }
+
+        line = trim(line);
+        if (line.empty()) {
+            continue;
+        }
+
+        if (line.find('/') != std::string_view::npos) {
+            if (auto network = IpNetwork::parse(line)) {
+                this->add(*network);
+                continue;
+            }
+        } else if (size_t dash = line.find('-'); dash != std::string_view::npos) {
+            auto first = IpAddress::parse(trim(line.substr(0, dash)));
+            auto last = IpAddress::parse(trim(line.substr(dash + 1)));
+
+            if (first && last && first->isV4() == last->isV4()) {
+                if (first->isV4()) {
+                    this->addRange(first->asV4(), last->asV4());
+                } else {
+                    this->addRange(first->asV6(), last->asV6());
+                }
+
+                continue;
+            }
+        } else if (auto addr = IpAddress::parse(line)) {
+            this->add(*addr);
+            continue;
+        }
+
+        failed++;
+    }
+
+    return failed;
+}
+
+size_t IpSetBuilder::size() const {
+    return m_v4.size() + m_v6.size();
+}
+
+std::vector<uint8_t> IpSetBuilder::compile() const {
+    // sort and merge overlapping or adjacent ranges
+
+    auto v4 = m_v4;
+    std::sort(v4.begin(), v4.end());
+
+    std::vector<std::pair<uint32_t, uint32_t>> merged4;
+    for (auto& range : v4) {
+        if (!merged4.empty() && (merged4.back().second == UINT32_MAX || range.first <= merged4.back().second + 1)) {
+            merged4.back().second = std::max(merged4.back().second, range.second);
+        } else {
+            merged4.push_back(range);
+        }
+    }
+
+    auto v6 = m_v6;
+    std::sort(v6.begin(), v6.end(), [](const Range6& a, const Range6& b) {
+        return std::tie(a.firstHi, a.firstLo, a.lastHi, a.lastLo) < std::tie(b.firstHi, b.firstLo, b.lastHi, b.lastLo);
+    });
+
+    std::vector<Range6> merged6;
+    for (auto& range : v6) {
+        if (!merged6.empty()) {
+            auto& back = merged6.back();
+
+            // the address right after the end of the previous range
+            uint64_t nextLo = back.lastLo + 1;
+            uint64_t nextHi = back.lastHi + (nextLo == 0 ? 1 : 0);
+            bool endsAtMax = back.lastHi == UINT64_MAX && back.lastLo == UINT64_MAX;
+
+            if (endsAtMax || std::pair(range.firstHi, range.firstLo) <= std::pair(nextHi, nextLo)) {
+                if (std::pair(range.lastHi, range.lastLo) > std::pair(back.lastHi, back.lastLo)) {
+                    back.lastHi = range.lastHi;
+                    back.lastLo = range.lastLo;
+                }
+
+                continue;
+            }
+        }
+
+        merged6.push_back(range);
+    }
+
+    // lay out the file
+
+    IpSetHeader header{};
+    memcpy(header.magic, IpSetMagic, sizeof(IpSetMagic));
+    header.version = IpSetVersion;
+    header.headerSize = sizeof(IpSetHeader);
+    header.v4Count = merged4.size();
+    header.v4Offset = sizeof(IpSetHeader);
+    header.v6Count = merged6.size();
+    header.v6Offset = header.v4Offset + v4SectionSize(merged4.size());
+    header.fileSize = header.v6Offset + v6SectionSize(merged6.size());
+
+    std::vector<uint8_t> out(header.fileSize);
+
+    auto* v4Starts = reinterpret_cast<uint32_t*>(out.data() + header.v4Offset);
+    auto* v4Ends = v4Starts + merged4.size();
+    auto* v4Index = v4Ends + merged4.size();
+
+    for (size_t i = 0; i < merged4.size(); i++) {
+        v4Starts[i] = merged4[i].first;
+        v4Ends[i] = merged4[i].second;
+    }
+
+    // index[t] is the first range that starts at or after t << 16
+    size_t range = 0;
+    for (size_t t = 0; t < V4IndexSize; t++) {
+        while (range < merged4.size() && (merged4[range].first >> 16) < t) {
+            range++;
+        }
+
+        v4Index[t] = static_cast<uint32_t>(range);
+    }
+
+    auto* v6Starts = reinterpret_cast<uint64_t*>(out.data() + header.v6Offset);
+    auto* v6Ends = v6Starts + merged6.size() * 2;
+
+    for (size_t i = 0; i < merged6.size(); i++) {
+        v6Starts[i * 2] = merged6[i].firstHi;
+        v6Starts[i * 2 + 1] = merged6[i].firstLo;
+        v6Ends[i * 2] = merged6[i].lastHi;
+        v6Ends[i * 2 + 1] = merged6[i].lastLo;
+    }
+
+    header.checksum = checksum(out.data() + sizeof(IpSetHeader), out.size() - sizeof(IpSetHeader));
+    memcpy(out.data(), &header, sizeof(header));
+
+    return out;
+}
+
+Result<void, IpSetError> IpSetBuilder::writeFile(const std::filesystem::path& path) const {
+    auto data = this->compile();
+
+    auto tempPath = path;
+    tempPath += ".tmp";
+
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return Err(IpSetError::WriteFailed);
+        }
+
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        // closing flushes, which is where a full disk shows up
+        file.close();
+        if (!file) {
+            std::error_code ec;
+            std::filesystem::remove(tempPath, ec);
+            return Err(IpSetError::WriteFailed);
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return Err(IpSetError::WriteFailed);
+    }
+
+    return Ok();
+}
+
+// MappedIpSet
+
+MappedIpSet::MappedIpSet() = default;
+MappedIpSet::MappedIpSet(MappedIpSet&& other) noexcept = default;
+MappedIpSet& MappedIpSet::operator=(MappedIpSet&& other) noexcept = default;
+MappedIpSet::~MappedIpSet() = default;
+
+Result<MappedIpSet, IpSetError> MappedIpSet::open(const std::filesystem::path& path, bool verifyChecksum) {
+    auto file = MappedFile::open(path);
+    if (!file) {
+        return Err(IpSetError::OpenFailed);
+    }
+
+    auto mapped = std::make_unique<MappedFile>(std::move(file).unwrap());
+
+    GEODE_UNWRAP_INTO(auto set, fromBuffer(mapped->data(), mapped->size(), verifyChecksum));
+    set.m_file = std::move(mapped);
+
+    return Ok(std::move(set));
+}
+
+Result<MappedIpSet, IpSetError> MappedIpSet::fromBuffer(const void* data, size_t size, bool verifyChecksum) {
+    auto bytes = static_cast<const uint8_t*>(data);
+
+    if (size < sizeof(IpSetHeader) || reinterpret_cast<uintptr_t>(data) % 8 != 0) {
+        return Err(IpSetError::InvalidFormat);
+    }
+
+    IpSetHeader header;
+    memcpy(&header, bytes, sizeof(header));
+
+    if (memcmp(header.magic, IpSetMagic, sizeof(IpSetMagic)) != 0) {
+        return Err(IpSetError::InvalidFormat);
+    }
+
+    if (header.version != IpSetVersion) {
+        return Err(IpSetError::UnsupportedVersion);
+    }
+
+    // validate the layout, so that a bad file can never cause out of bounds reads
+    if (header.headerSize != sizeof(IpSetHeader)
+        || header.fileSize != size
+        || header.v4Count > UINT32_MAX
+        || header.v6Count > size
+        || header.v4Offset != sizeof(IpSetHeader)
+        || header.v6Offset != header.v4Offset + v4SectionSize(header.v4Count)
+        || header.fileSize != header.v6Offset + v6SectionSize(header.v6Count))
+    {
+        return Err(IpSetError::InvalidFormat);
+    }
+
+    if (verifyChecksum && checksum(bytes + sizeof(IpSetHeader), size - sizeof(IpSetHeader)) != header.checksum) {
+        return Err(IpSetError::ChecksumMismatch);
+    }
+
+    MappedIpSet set;
+    set.m_v4Count = header.v4Count;
+    set.m_v4Starts = reinterpret_cast<const uint32_t*>(bytes + header.v4Offset);
+    set.m_v4Ends = set.m_v4Starts + set.m_v4Count;
+    set.m_v4Index = set.m_v4Ends + set.m_v4Count;
+    set.m_v6Count = header.v6Count;
+    set.m_v6Starts = reinterpret_cast<const uint64_t*>(bytes + header.v6Offset);
+    set.m_v6Ends = set.m_v6Starts + set.m_v6Count * 2;
+
+    // lookups index the range arrays through the index, so it must be in bounds even if the checksum was skipped
+    for (size_t t = 0; t < V4IndexSize; t++) {
+        uint32_t prev = t == 0 ? 0 : set.m_v4Index[t - 1];
+        if (set.m_v4Index[t] < prev || set.m_v4Index[t] > set.m_v4Count) {
+            return Err(IpSetError::InvalidFormat);
+        }
+    }
+
+    if (set.m_v4Index[V4IndexSize - 1] != set.m_v4Count) {
+        return Err(IpSetError::InvalidFormat);
+    }
+
+    return Ok(std::move(set));
+}
+
+bool MappedIpSet::contains(const Ipv4Address& addr) const {
+    uint32_t bits = addr.toBits();
+    uint32_t top = bits >> 16;
+
+    // the last range starting at or before the address is either within this bucket, or the one right before it
+    const uint32_t* begin = m_v4Starts + m_v4Index[top];
+    const uint32_t* end = m_v4Starts + m_v4Index[top + 1];
+    size_t pos = std::upper_bound(begin, end, bits) - m_v4Starts;
+
+    return pos > 0 && bits <= m_v4Ends[pos - 1];
+}
+
+bool MappedIpSet::contains(const Ipv6Address& addr) const {
+    auto key = toHalves(addr);
+
+    // find the amount of ranges starting at or before the address
+    size_t lo = 0, hi = m_v6Count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (std::pair(m_v6Starts[mid * 2], m_v6Starts[mid * 2 + 1]) <= key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo > 0 && key <= std::pair(m_v6Ends[(lo - 1) * 2], m_v6Ends[(lo - 1) * 2 + 1]);
+}
+
+bool MappedIpSet::contains(const IpAddress& addr) const {
+    return addr.isV4() ? this->contains(addr.asV4()) : this->contains(addr.asV6());
+}
+
+size_t MappedIpSet::v4RangeCount() const {
+    return m_v4Count;
+}
+
+size_t MappedIpSet::v6RangeCount() const {
+    return m_v6Count;
+}
+
+} // namespace qsox
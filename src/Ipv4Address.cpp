@@ -1,7 +1,14 @@
 #include <qsox/Ipv4Address.hpp>
 #include <qsox/Util.hpp>
-#include <fmt/format.h>
+#include "FormatUtil.hpp"
+#include <bit>
 #include <charconv>
+#include <optional>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define QSOX_HAS_SSE2 1
+#endif
 
 #ifdef _WIN32
 # include <WinSock2.h>
@@ -29,7 +36,118 @@ std::string_view Ipv4ParseError::message() const {
     qsox::unreachable();
 }
 
+struct CharMasks {
+    uint32_t digits; // bit i is set if str[i] is a decimal digit
+    uint32_t dots;   // bit i is set if str[i] is a '.'
+};
+
+// Classifies all 16 bytes of `buf` at once
+static CharMasks classify(const char* buf) {
+#ifdef QSOX_HAS_SSE2
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf));
+
+    // signed comparisons, so bytes >= 0x80 are never considered digits
+    __m128i digits = _mm_and_si128(
+        _mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+        _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1))
+    );
+    __m128i dots = _mm_cmpeq_epi8(v, _mm_set1_epi8('.'));
+
+    return CharMasks {
+        static_cast<uint32_t>(_mm_movemask_epi8(digits)),
+        static_cast<uint32_t>(_mm_movemask_epi8(dots)),
+    };
+#else
+    // SWAR fallback, same idea with two 64-bit words
+    constexpr uint64_t Ones = 0x0101010101010101ull;
+    constexpr uint64_t High = 0x8080808080808080ull;
+
+    // gathers the high bit of every byte into an 8-bit mask, byte i becomes bit i
+    auto movemask = [](uint64_t v) {
+        return static_cast<uint32_t>((((v & High) >> 7) * 0x0102040810204080ull) >> 56);
+    };
+
+    auto classifyWord = [&](uint64_t x, uint32_t& digits, uint32_t& dots) {
+        uint64_t y = x & ~High;
+        uint64_t isDigit = (y + Ones * (0x80 - '0')) & ~(y + Ones * (0x7f - '9')) & ~x;
+        uint64_t eqDot = y ^ (Ones * '.');
+        uint64_t isDot = ~((eqDot & ~High) + ~High) & ~eqDot & ~x; // zero byte detection
+
+        digits = movemask(isDigit);
+        dots = movemask(isDot);
+    };
+
+    uint64_t lo, hi;
+    memcpy(&lo, buf, 8);
+    memcpy(&hi, buf + 8, 8);
+
+    uint32_t loDigits, loDots, hiDigits, hiDots;
+    classifyWord(lo, loDigits, loDots);
+    classifyWord(hi, hiDigits, hiDots);
+
+    return CharMasks { loDigits | (hiDigits << 8), loDots | (hiDots << 8) };
+#endif
+}
+
+// Fast path for the common form of an address (4 octets, 1-3 digits each, no leading zeros check).
+// Returns std::nullopt if the string is not in that form, in which case the scalar parser decides.
+static std::optional<Ipv4Address> parseFast(std::string_view str) {
+    size_t len = str.size();
+    if (len < 7 || len > 15) {
+        return std::nullopt;
+    }
+
+    char buf[16] = {};
+    memcpy(buf, str.data(), len);
+
+    auto masks = classify(buf);
+
+    // every character must be a digit or a dot, and there must be exactly 3 dots
+    uint32_t used = (1u << len) - 1;
+    if ((masks.digits | masks.dots) != used || std::popcount(masks.dots) != 3) {
+        return std::nullopt;
+    }
+
+    // octet boundaries, with an imaginary dot right after the string
+    uint32_t dots = masks.dots | (1u << len);
+    Ipv4Address out;
+    size_t start = 0;
+
+    for (size_t i = 0; i < 4; i++) {
+        size_t end = std::countr_zero(dots);
+        dots &= dots - 1;
+
+        size_t digits = end - start;
+        const char* p = buf + start;
+
+        uint32_t value;
+        switch (digits) {
+            case 1: value = p[0] - '0'; break;
+            case 2: value = (p[0] - '0') * 10 + (p[1] - '0'); break;
+            case 3: value = (p[0] - '0') * 100 + (p[1] - '0') * 10 + (p[2] - '0'); break;
+            default: return std::nullopt;
+        }
+
+        if (value > 255) {
+            return std::nullopt;
+        }
+
+        out[i] = static_cast<uint8_t>(value);
+        start = end + 1;
+    }
+
+    return out;
+}
+
 Result<Ipv4Address, Ipv4ParseError> Ipv4Address::parse(std::string_view str) {
+    if (auto addr = parseFast(str)) {
+        return Ok(*addr);
+    }
+
+    return parseScalar(str);
+}
+
+Result<Ipv4Address, Ipv4ParseError> Ipv4Address::parseScalar(std::string_view str) {
     Ipv4Address out;
 
     for (size_t i = 0; i < 4; i++) {
@@ -45,9 +163,9 @@ Result<Ipv4Address, Ipv4ParseError> Ipv4Address::parse(std::string_view str) {
         std::string_view octetStr = str.substr(0, nextDot);
 
         uint8_t octet;
-        auto result = std::from_chars(&*octetStr.begin(), &*octetStr.end(), octet);
+        auto result = std::from_chars(octetStr.data(), octetStr.data() + octetStr.size(), octet);
 
-        if (result.ec != std::errc()) {
+        if (result.ec != std::errc() || result.ptr != octetStr.data() + octetStr.size()) {
             return Err(Ipv4ParseError::InvalidOctet);
         }
 
@@ -67,19 +185,80 @@ Result<Ipv4Address, Ipv4ParseError> Ipv4Address::parse(std::string_view str) {
     return Ok(out);
 }
 
-std::string Ipv4Address::toString() const {
-    std::string str;
-    str.reserve(15);
+static std::string_view trimEntry(std::string_view str) {
+    while (!str.empty() && (str.front() == ' ' || str.front() == '\t')) {
+        str.remove_prefix(1);
+    }
 
-    for (size_t i = 0; i < 4; i++) {
-        fmt::format_to(std::back_inserter(str), "{}", m_octets[i]);
+    while (!str.empty() && (str.back() == ' ' || str.back() == '\t' || str.back() == '\r')) {
+        str.remove_suffix(1);
+    }
 
-        if (i < 3) {
-            str.push_back('.');
+    return str;
+}
+
+size_t Ipv4Address::parseMany(std::string_view input, std::vector<Ipv4Address>& out, char delimiter) {
+    size_t failed = 0;
+
+    // rough estimate, most addresses with a separator are around 12-16 characters
+    out.reserve(out.size() + input.size() / 12);
+
+    auto parseEntry = [&](std::string_view entry) {
+        entry = trimEntry(entry);
+        if (entry.empty()) {
+            return;
+        }
+
+        if (auto addr = parseFast(entry)) {
+            out.push_back(*addr);
+        } else if (auto addr = parseScalar(entry)) {
+            out.push_back(*addr);
+        } else {
+            failed++;
+        }
+    };
+
+    // memchr is vectorized by the C library, so scanning for separators is cheap
+    while (!input.empty()) {
+        auto lineEnd = static_cast<const char*>(memchr(input.data(), '\n', input.size()));
+        size_t lineLen = lineEnd ? static_cast<size_t>(lineEnd - input.data()) : input.size();
+        std::string_view line = input.substr(0, lineLen);
+        input.remove_prefix(lineEnd ? lineLen + 1 : lineLen);
+
+        if (delimiter == '\n') {
+            parseEntry(line);
+            continue;
+        }
+
+        while (true) {
+            auto fieldEnd = static_cast<const char*>(memchr(line.data(), delimiter, line.size()));
+            if (!fieldEnd) {
+                parseEntry(line);
+                break;
+            }
+
+            size_t fieldLen = fieldEnd - line.data();
+            parseEntry(line.substr(0, fieldLen));
+            line.remove_prefix(fieldLen + 1);
         }
     }
 
-    return str;
+    return failed;
+}
+
+std::string Ipv4Address::toString() const {
+    char buf[MaxStringLength];
+    return std::string(buf, this->toChars(buf));
+}
+
+char* Ipv4Address::toChars(char* buf) const {
+    buf = fmtutil::writeDecimal(buf, m_octets[0]);
+    *buf++ = '.';
+    buf = fmtutil::writeDecimal(buf, m_octets[1]);
+    *buf++ = '.';
+    buf = fmtutil::writeDecimal(buf, m_octets[2]);
+    *buf++ = '.';
+    return fmtutil::writeDecimal(buf, m_octets[3]);
 }
 
 void Ipv4Address::toInAddr(struct in_addr& addr) const {
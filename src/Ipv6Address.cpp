@@ -1,11 +1,14 @@
 #include <qsox/Ipv6Address.hpp>
 #include <qsox/Util.hpp>
-#include <fmt/format.h>
+#include "FormatUtil.hpp"
+#include <algorithm>
+
+#include <bit>
 
 #ifdef _WIN32
-# include <ws2tcpip.h> // inet_pton
+# include <ws2tcpip.h> // in6_addr
 #else
-# include <arpa/inet.h> // inet_pton
+# include <netinet/in.h> // in6_addr
 #endif
 
 namespace qsox {
@@ -82,21 +85,170 @@ Ipv6Address Ipv6Address::fromIpv4Mapped(const Ipv4Address& addr) {
     return Ipv6Address(octets);
 }
 
-Result<Ipv6Address, Ipv6ParseError> Ipv6Address::parse(const std::string& str) {
-    // Parsing an IPv6 address is significantly more complex than ipv4, so let's just use inet_pton for now
+// Returns the amount of consecutive hex digits at `ptr` (at most 8). `ptr` must have 8 readable bytes.
+// All 8 bytes are classified at once, by doing per-byte range checks within a single 64-bit word.
+static size_t hexDigitRun(const char* ptr) {
+    constexpr uint64_t Ones = 0x0101010101010101ull;
+    constexpr uint64_t High = 0x8080808080808080ull;
 
-    Ipv6Address addr;
-    if (inet_pton(AF_INET6, str.c_str(), addr.m_octets.data()) != 1) {
+    uint64_t x;
+    memcpy(&x, ptr, sizeof(x));
+
+    // clear the high bits so that additions below never carry into the next byte,
+    // bytes that had it set are not ASCII and are excluded at the end
+    uint64_t y = x & ~High;
+
+    // high bit of each byte is set if the byte is within [lo, hi]
+    auto inRange = [](uint64_t v, uint8_t lo, uint8_t hi) {
+        return (v + Ones * (0x80 - lo)) & ~(v + Ones * (0x7f - hi));
+    };
+
+    uint64_t digits = inRange(y, '0', '9');
+    uint64_t letters = inRange(y | (Ones * 0x20), 'a', 'f'); // | 0x20 folds uppercase into lowercase
+    uint64_t hex = (digits | letters) & ~x & High;
+
+    // bytes were loaded in little-endian order, so the first non-hex byte is the lowest one
+    uint64_t nonHex = ~hex & High;
+    return nonHex == 0 ? 8 : std::countr_zero(nonHex) / 8;
+}
+
+static uint8_t hexDigitValue(char c) {
+    // works for '0'-'9', 'a'-'f' and 'A'-'F', bit 6 is only set for letters
+    return (c & 0xf) + 9 * ((c >> 6) & 1);
+}
+
+Result<Ipv6Address, Ipv6ParseError> Ipv6Address::parse(std::string_view str) {
+    // allow the address to be enclosed in square brackets
+    if (!str.empty() && str.front() == '[') {
+        if (str.size() < 2 || str.back() != ']') {
+            return Err(Ipv6ParseError::Unspecified);
+        }
+
+        str.remove_prefix(1);
+        str.remove_suffix(1);
+    }
+
+    return parseBare(str);
+}
+
+Result<Ipv6Address, Ipv6ParseError> Ipv6Address::parseBare(std::string_view str) {
+    // longest valid form is 'ffff:ffff:ffff:ffff:ffff:ffff:255.255.255.255'
+    if (str.size() < 2 || str.size() > 45) {
         return Err(Ipv6ParseError::Unspecified);
     }
 
+    // copy into a zero padded buffer, so that 8 bytes can always be read at any position
+    char padded[45 + 8] = {};
+    memcpy(padded, str.data(), str.size());
+
+    std::array<uint16_t, 8> groups{};
+    size_t count = 0;
+    size_t compressAt = SIZE_MAX; // index of the group where '::' is, if any
+    size_t i = 0;
+
+    if (str[0] == ':') {
+        if (str[1] != ':') {
+            return Err(Ipv6ParseError::Unspecified);
+        }
+
+        compressAt = 0;
+        i = 2;
+    }
+
+    while (i < str.size()) {
+        size_t len = hexDigitRun(padded + i);
+
+        if (len == 0) {
+            return Err(Ipv6ParseError::Unspecified);
+        }
+
+        // embedded IPv4 address, must take up the rest of the string and the last 2 groups
+        if (i + len < str.size() && str[i + len] == '.') {
+            if (count > 6) {
+                return Err(Ipv6ParseError::Unspecified);
+            }
+
+            auto v4Str = str.substr(i);
+            bool onlyDigits = std::all_of(v4Str.begin(), v4Str.end(), [](char c) {
+                return (c >= '0' && c <= '9') || c == '.';
+            });
+
+            auto v4 = Ipv4Address::parse(v4Str);
+            if (!onlyDigits || !v4) {
+                return Err(Ipv6ParseError::Unspecified);
+            }
+
+            groups[count++] = static_cast<uint16_t>((*v4)[0] << 8 | (*v4)[1]);
+            groups[count++] = static_cast<uint16_t>((*v4)[2] << 8 | (*v4)[3]);
+            i = str.size();
+            break;
+        }
+
+        if (len > 4 || count == 8) {
+            return Err(Ipv6ParseError::Unspecified);
+        }
+
+        uint16_t group = 0;
+        for (size_t j = 0; j < len; j++) {
+            group = static_cast<uint16_t>(group << 4 | hexDigitValue(str[i + j]));
+        }
+
+        groups[count++] = group;
+        i += len;
+
+        if (i == str.size()) {
+            break;
+        }
+
+        if (str[i] != ':') {
+            return Err(Ipv6ParseError::Unspecified);
+        }
+
+        i++;
+
+        if (i < str.size() && str[i] == ':') {
+            if (compressAt != SIZE_MAX) {
+                return Err(Ipv6ParseError::Unspecified);
+            }
+
+            compressAt = count;
+            i++;
+        } else if (i == str.size()) {
+            // trailing single colon
+            return Err(Ipv6ParseError::Unspecified);
+        }
+    }
+
+    if (compressAt == SIZE_MAX ? count != 8 : count > 7) {
+        return Err(Ipv6ParseError::Unspecified);
+    }
+
+    // expand '::' by moving the groups after it to the end
+    if (compressAt != SIZE_MAX) {
+        size_t tail = count - compressAt;
+        std::copy_backward(groups.begin() + compressAt, groups.begin() + count, groups.end());
+        std::fill(groups.begin() + compressAt, groups.end() - tail, 0);
+    }
+
+    Ipv6Address addr;
+    for (size_t g = 0; g < 8; g++) {
+        addr.m_octets[g * 2] = static_cast<uint8_t>(groups[g] >> 8);
+        addr.m_octets[g * 2 + 1] = static_cast<uint8_t>(groups[g]);
+    }
+
     return Ok(addr);
 }
 
 std::string Ipv6Address::toString() const {
+    char buf[MaxStringLength];
+    return std::string(buf, this->toChars(buf));
+}
+
+char* Ipv6Address::toChars(char* buf) const {
     auto mappedV4 = this->toIpv4Mapped();
     if (mappedV4) {
-        return fmt::format("::ffff:{}", mappedV4->toString());
+        memcpy(buf, "::ffff:", 7);
+        return mappedV4->toChars(buf + 7);
     }
 
     auto segments = this->segments();
@@ -127,32 +279,26 @@ std::string Ipv6Address::toString() const {
         }
     }
 
-    std::string out;
-    out.reserve(39);
-
     auto writeSubslice = [&](size_t start, size_t count) {
-        if (count == 0) {
-            return;
-        }
-
         for (size_t i = start; i < start + count; i++) {
             if (i > start) {
-                out.append(":");
+                *buf++ = ':';
             }
 
-            fmt::format_to(std::back_inserter(out), "{:x}", segments[i]);
+            buf = fmtutil::writeHex(buf, segments[i]);
         }
     };
 
     if (longest.length > 1) {
         writeSubslice(0, longest.start);
-        out.append("::");
+        *buf++ = ':';
+        *buf++ = ':';
         writeSubslice(longest.start + longest.length, segments.size() - (longest.start + longest.length));
     } else {
         writeSubslice(0, segments.size());
     }
 
-    return out;
+    return buf;
 }
 
 void Ipv6Address::toInAddr(in6_addr& addr) const {
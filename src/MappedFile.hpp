@@ -0,0 +1,39 @@
+#pragma once
+
+#include <qsox/Error.hpp>
+#include <filesystem>
+#include <stddef.h>
+
+namespace qsox {
+
+// Read-only memory mapping of a whole file. Pages are shared with every other process mapping the same file.
+class MappedFile {
+public:
+    static NetResult<MappedFile> open(const std::filesystem::path& path);
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const void* data() const {
+        return m_data;
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+private:
+    const void* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_mapping = nullptr;
+#endif
+
+    MappedFile() = default;
+    void unmap();
+};
+
+} // namespace qsox
@@ -1,9 +1,28 @@
 #include <qsox/NetworkAddress.hpp>
-#include <fmt/format.h>
+#include "FormatUtil.hpp"
+#include <atomic>
 #include <charconv>
 
 namespace qsox {
 
+static std::atomic<int64_t> g_resolveTtlMs{60000};
+static std::atomic<int64_t> g_failedResolveTtlMs{5000};
+
+NetworkAddress::NetworkAddress(const NetworkAddress& other)
+    : m_host(other.m_host), m_port(other.m_port), m_literal(other.m_literal),
+      m_cache(std::atomic_load_explicit(&other.m_cache, std::memory_order_acquire)) {}
+
+NetworkAddress& NetworkAddress::operator=(const NetworkAddress& other) {
+    if (this != &other) {
+        m_host = other.m_host;
+        m_port = other.m_port;
+        m_literal = other.m_literal;
+        std::atomic_store_explicit(&m_cache, std::atomic_load_explicit(&other.m_cache, std::memory_order_acquire), std::memory_order_release);
+    }
+
+    return *this;
+}
+
 std::string_view NetworkAddressParseError::message() const {
     switch (m_code) {
         case MissingPort:
@@ -15,8 +34,44 @@ std::string_view NetworkAddressParseError::message() const {
     qsox::unreachable();
 }
 
+void NetworkAddress::updateLiteral() {
+    if (auto addr = IpAddress::parse(m_host)) {
+        m_literal = *addr;
+    } else {
+        m_literal = std::nullopt;
+    }
+}
+
+void NetworkAddress::invalidate() {
+    std::atomic_store_explicit(&m_cache, std::shared_ptr<const ResolveSnapshot>{}, std::memory_order_release);
+}
+
+void NetworkAddress::setResolveTtl(std::chrono::milliseconds ttl) {
+    g_resolveTtlMs.store(ttl.count(), std::memory_order_relaxed);
+}
+
+std::chrono::milliseconds NetworkAddress::resolveTtl() {
+    return std::chrono::milliseconds(g_resolveTtlMs.load(std::memory_order_relaxed));
+}
+
+void NetworkAddress::setFailedResolveTtl(std::chrono::milliseconds ttl) {
+    g_failedResolveTtlMs.store(ttl.count(), std::memory_order_relaxed);
+}
+
+std::chrono::milliseconds NetworkAddress::failedResolveTtl() {
+    return std::chrono::milliseconds(g_failedResolveTtlMs.load(std::memory_order_relaxed));
+}
+
 std::string NetworkAddress::toString() const {
-    return fmt::format("{}:{}", m_host, m_port);
+    std::string out;
+    out.reserve(m_host.size() + 6);
+    out.append(m_host);
+    out.push_back(':');
+
+    char port[5];
+    out.append(port, fmtutil::writeDecimal(port, m_port));
+
+    return out;
 }
 
 Result<NetworkAddress, NetworkAddressParseError> NetworkAddress::parse(std::string_view str) {
@@ -37,40 +92,101 @@ Result<NetworkAddress, NetworkAddressParseError> NetworkAddress::parse(std::stri
     return Ok(NetworkAddress(std::move(host), port));
 }
 
+template <typename F>
+Result<IpAddress, resolver::Error> NetworkAddress::resolveCached(CacheSlot slot, F&& resolveFn) const {
+    size_t index = static_cast<size_t>(slot);
+
+    // fast path: one atomic load, no locking
+    auto snapshot = std::atomic_load_explicit(&m_cache, std::memory_order_acquire);
+    if (snapshot && snapshot->slots[index] && Clock::now() < snapshot->slots[index]->expiresAt) {
+        auto& entry = *snapshot->slots[index];
+        if (entry.address) {
+            return Ok(*entry.address);
+        }
+
+        return Err(entry.error);
+    }
+
+    Result<IpAddress, resolver::Error> result = resolveFn();
+
+    auto ttl = result ? resolveTtl() : failedResolveTtl();
+    if (ttl.count() <= 0) {
+        return result;
+    }
+
+    CachedResult entry;
+    entry.expiresAt = Clock::now() + ttl;
+    if (result) {
+        entry.address = *result;
+    } else {
+        entry.error = result.unwrapErr();
+    }
+
+    // publish a new snapshot with this slot replaced, retrying if another thread published one in the meantime
+    auto current = std::atomic_load_explicit(&m_cache, std::memory_order_acquire);
+    while (true) {
+        auto next = std::make_shared<ResolveSnapshot>(current ? *current : ResolveSnapshot{});
+        next->slots[index] = entry;
+
+        std::shared_ptr<const ResolveSnapshot> published = std::move(next);
+        if (std::atomic_compare_exchange_weak_explicit(&m_cache, &current, published, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            break;
+        }
+    }
+
+    return result;
+}
 
 Result<SocketAddressV4, resolver::Error> NetworkAddress::resolveV4() const {
-    // Try to parse the host as an IPv4 address first
-    if (auto addr = Ipv4Address::parse(m_host)) {
-        return Ok(SocketAddressV4(*addr, m_port));
+    if (m_literal) {
+        if (!m_literal->isV4()) {
+            return Err(resolver::Error::AddrFamily);
+        }
+
+        return Ok(SocketAddressV4(m_literal->asV4(), m_port));
     }
 
-    return resolver::resolveIpv4(m_host).map([this](const Ipv4Address& addr) {
-        return SocketAddressV4(addr, m_port);
+    auto result = this->resolveCached(CacheSlot::V4, [this]() {
+        return resolver::resolveIpv4(m_host).map([](const Ipv4Address& addr) {
+            return IpAddress(addr);
+        });
+    });
+
+    return result.map([this](const IpAddress& addr) {
+        return SocketAddressV4(addr.asV4(), m_port);
     });
 }
 
 Result<SocketAddressV6, resolver::Error> NetworkAddress::resolveV6() const {
-    // Try to parse the host as an IPv6 address first
-    if (auto addr = Ipv6Address::parse(m_host)) {
-        return Ok(SocketAddressV6(*addr, m_port));
+    if (m_literal) {
+        if (!m_literal->isV6()) {
+            return Err(resolver::Error::AddrFamily);
+        }
+
+        return Ok(SocketAddressV6(m_literal->asV6(), m_port));
     }
 
-    return resolver::resolveIpv6(m_host).map([this](const Ipv6Address& addr) {
-        return SocketAddressV6(addr, m_port);
+    auto result = this->resolveCached(CacheSlot::V6, [this]() {
+        return resolver::resolveIpv6(m_host).map([](const Ipv6Address& addr) {
+            return IpAddress(addr);
+        });
+    });
+
+    return result.map([this](const IpAddress& addr) {
+        return SocketAddressV6(addr.asV6(), m_port);
     });
 }
 
 Result<SocketAddress, resolver::Error> NetworkAddress::resolve() const {
-    // try to parse as ipv4, then ipv6, then resolve to either
-    if (auto addr = Ipv4Address::parse(m_host)) {
-        return Ok(SocketAddressV4(*addr, m_port));
+    if (m_literal) {
+        return Ok(SocketAddress(*m_literal, m_port));
     }
 
-    if (auto addr = Ipv6Address::parse(m_host)) {
-        return Ok(SocketAddressV6(*addr, m_port));
-    }
+    auto result = this->resolveCached(CacheSlot::Any, [this]() {
+        return resolver::resolve(m_host);
+    });
 
-    return resolver::resolve(m_host).map([this](const IpAddress& addr) {
+    return result.map([this](const IpAddress& addr) {
         return SocketAddress(addr, m_port);
     });
 }
@@ -5,6 +5,7 @@
 #include <qsox/Resolver.hpp>
 #include <qsox/Util.hpp>
 #include <string.h>
+#include "SocketUtil.hpp"
 
 #ifdef _WIN32
 # include <ws2tcpip.h>
@@ -199,10 +200,18 @@ Result<Ip> findAndConvert(const std::string& hostname, int timeoutMs) {
 }
 
 Result<Ipv4Address> resolveIpv4(const std::string& hostname, int timeoutMs) {
+    if (auto addr = lookupHostsIpv4(hostname)) {
+        return Ok(*addr);
+    }
+
     return findAndConvert<Ipv4Address, struct sockaddr_in, AF_INET>(hostname, timeoutMs);
 }
 
 Result<Ipv6Address> resolveIpv6(const std::string& hostname, int timeoutMs) {
+    if (auto addr = lookupHostsIpv6(hostname)) {
+        return Ok(*addr);
+    }
+
     return findAndConvert<Ipv6Address, struct sockaddr_in6, AF_INET6>(hostname, timeoutMs);
 }
 
@@ -217,4 +226,22 @@ Result<IpAddress> resolve(const std::string& hostname, int timeoutMs) {
     }
 }
 
+Result<std::string> reverseLookup(const IpAddress& address) {
+    if (!startupSockets()) {
+        return Err(Error::Other);
+    }
+
+    SockAddrAny addrStorage = SocketAddress{address, 0};
+
+    // NI_MAXHOST is 1025, including the null terminator
+    char host[1025];
+
+    int ret = getnameinfo(addrStorage.asSockaddr(), addrStorage.size(), host, sizeof(host), nullptr, 0, NI_NAMEREQD);
+    if (ret != 0) {
+        return Err(makeError(ret));
+    }
+
+    return Ok(std::string(host));
+}
+
 } // namespace qsox::resolver,
@@ -0,0 +1,136 @@
+#include <qsox/ReverseResolver.hpp>
+#include "BackgroundWorker.hpp"
+
+namespace qsox::resolver {
+
+ReverseResolver::ReverseResolver(ReverseCacheOptions options)
+    : m_options(options), m_worker(std::make_unique<BackgroundWorker>(options.threads)) {}
+
+ReverseResolver::~ReverseResolver() {
+    // join the workers before the rest of the state is destroyed
+    m_worker.reset();
+}
+
+ReverseResolver& ReverseResolver::global() {
+    static ReverseResolver resolver;
+    return resolver;
+}
+
+std::optional<Result<std::string>> ReverseResolver::cached(const IpAddress& address) {
+    std::lock_guard lock(m_mutex);
+    return this->findLocked(address);
+}
+
+void ReverseResolver::lookup(const IpAddress& address, Callback callback) {
+    std::unique_lock lock(m_mutex);
+
+    if (auto result = this->findLocked(address)) {
+        lock.unlock();
+        callback(address, *result);
+        return;
+    }
+
+    if (m_pendingCallbacks >= m_options.maxPending) {
+        lock.unlock();
+        callback(address, Err(Error::TemporaryFailure));
+        return;
+    }
+
+    auto [it, inserted] = m_pending.try_emplace(address);
+    it->second.push_back(std::move(callback));
+    m_pendingCallbacks++;
+
+    if (!inserted) {
+        // a lookup is already in flight, the callback will be invoked when it completes
+        return;
+    }
+
+    m_worker->submit([this, address] {
+        this->complete(address, reverseLookup(address));
+    });
+}
+
+std::shared_future<Result<std::string>> ReverseResolver::lookup(const IpAddress& address) {
+    auto promise = std::make_shared<std::promise<Result<std::string>>>();
+    std::shared_future<Result<std::string>> future = promise->get_future().share();
+
+    this->lookup(address, [promise](const IpAddress&, const Result<std::string>& result) {
+        promise->set_value(result);
+    });
+
+    return future;
+}
+
+void ReverseResolver::clear() {
+    std::lock_guard lock(m_mutex);
+    m_entries.clear();
+    m_lru.clear();
+}
+
+std::optional<Result<std::string>> ReverseResolver::findLocked(const IpAddress& address) {
+    auto it = m_entries.find(address);
+    if (it == m_entries.end()) {
+        return std::nullopt;
+    }
+
+    auto entry = it->second;
+
+    if (Clock::now() >= entry->expiresAt) {
+        m_lru.erase(entry);
+        m_entries.erase(it);
+        return std::nullopt;
+    }
+
+    // move to the front
+    m_lru.splice(m_lru.begin(), m_lru, entry);
+
+    return entry->result;
+}
+
+void ReverseResolver::complete(const IpAddress& address, Result<std::string> result) {
+    std::vector<Callback> callbacks;
+
+    {
+        std::lock_guard lock(m_mutex);
+
+        auto ttl = result.isOk() ? m_options.ttl : m_options.negativeTtl;
+
+        // a timed out or temporarily failed lookup says nothing about the address, so don't cache it
+        bool transient = result.isErr()
+            && (result.unwrapErr() == Error::TimedOut || result.unwrapErr() == Error::TemporaryFailure);
+
+        if (!transient && m_options.capacity > 0) {
+            auto it = m_entries.find(address);
+            if (it != m_entries.end()) {
+                m_lru.erase(it->second);
+                m_entries.erase(it);
+            }
+
+            while (m_lru.size() >= m_options.capacity) {
+                m_entries.erase(m_lru.back().address);
+                m_lru.pop_back();
+            }
+
+            m_lru.push_front(Entry {
+                .address = address,
+                .result = result,
+                .expiresAt = Clock::now() + ttl,
+            });
+
+            m_entries.emplace(address, m_lru.begin());
+        }
+
+        auto pending = m_pending.find(address);
+        if (pending != m_pending.end()) {
+            callbacks = std::move(pending->second);
+            m_pending.erase(pending);
+            m_pendingCallbacks -= callbacks.size();
+        }
+    }
+
+    for (auto& callback : callbacks) {
+        callback(address, result);
+    }
+}
+
+} // namespace qsox::resolver
@@ -1,5 +1,4 @@
 #include <qsox/SocketAddress.hpp>
-#include <fmt/format.h>
 #include <charconv>
 
 #ifdef _WIN32
@@ -25,10 +24,15 @@ std::string_view SocketAddressParseError::message() const {
 }
 
 std::string SocketAddress::toString() const {
+    char buf[MaxStringLength];
+    return std::string(buf, this->toChars(buf));
+}
+
+char* SocketAddress::toChars(char* buf) const {
     if (this->isV4()) {
-        return fmt::format("{}:{}", m_address.asV4().toString(), m_port);
+        return this->toV4().toChars(buf);
     } else {
-        return fmt::format("[{}]:{}", m_address.asV6().toString(), m_port);
+        return this->toV6().toChars(buf);
     }
 }
 
@@ -48,14 +52,14 @@ Result<SocketAddress, SocketAddressParseError> SocketAddress::parse(std::string_
         addressPart.remove_prefix(1);
         addressPart.remove_suffix(1);
 
-        auto addr = Ipv6Address::parse(std::string(addressPart));
+        auto addr = Ipv6Address::parseBare(addressPart);
         if (!addr) {
             return Err(SocketAddressParseError::InvalidAddress);
         }
 
         outAddr = *addr;
     } else {
-        auto addr = Ipv4Address::parse(std::string(addressPart));
+        auto addr = Ipv4Address::parse(addressPart);
         if (!addr) {
             return Err(SocketAddressParseError::InvalidAddress);
         }
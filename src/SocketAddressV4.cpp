@@ -1,6 +1,6 @@
 #include <qsox/SocketAddressV4.hpp>
 #include <qsox/Util.hpp>
-#include <fmt/format.h>
+#include "FormatUtil.hpp"
 #include <charconv>
 
 #ifdef _WIN32
@@ -66,12 +66,14 @@ Result<SocketAddressV4, SocketAddressV4ParseError> SocketAddressV4::parse(std::s
 }
 
 std::string SocketAddressV4::toString() const {
-    std::string result = m_address.toString();
-
-    result.push_back(':');
-    fmt::format_to(std::back_inserter(result), "{}", m_port);
+    char buf[MaxStringLength];
+    return std::string(buf, this->toChars(buf));
+}
 
-    return result;
+char* SocketAddressV4::toChars(char* buf) const {
+    buf = m_address.toChars(buf);
+    *buf++ = ':';
+    return fmtutil::writeDecimal(buf, m_port);
 }
 
 void SocketAddressV4::toSockAddr(sockaddr_in& addr) const {
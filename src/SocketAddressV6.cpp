@@ -1,6 +1,6 @@
 #include <qsox/SocketAddressV6.hpp>
 #include <qsox/Util.hpp>
-#include <fmt/format.h>
+#include "FormatUtil.hpp"
 #include <charconv>
 
 #ifdef _WIN32
@@ -53,7 +53,7 @@ Result<SocketAddressV6, SocketAddressV6ParseError> SocketAddressV6::parse(std::s
     addressPart.remove_prefix(1); // remove '['
     addressPart.remove_suffix(1); // remove ']'
 
-    auto address = Ipv6Address::parse(std::string(addressPart));
+    auto address = Ipv6Address::parseBare(addressPart);
     if (address.isErr()) {
         return Err(fromIpError(address.unwrapErr()));
     }
@@ -68,12 +68,17 @@ Result<SocketAddressV6, SocketAddressV6ParseError> SocketAddressV6::parse(std::s
 }
 
 std::string SocketAddressV6::toString() const {
-    std::string result = m_address.toString();
-
-    result.push_back(':');
-    fmt::format_to(std::back_inserter(result), "{}", m_port);
+    char buf[MaxStringLength];
+    return std::string(buf, this->toChars(buf));
+}
 
-    return result;
+char* SocketAddressV6::toChars(char* buf) const {
+    // brackets are required to separate the port, this matches what `parse` accepts
+    *buf++ = '[';
+    buf = m_address.toChars(buf);
+    *buf++ = ']';
+    *buf++ = ':';
+    return fmtutil::writeDecimal(buf, m_port);
 }
 
 void SocketAddressV6::toSockAddr(sockaddr_in6& addr) const {
@@ -0,0 +1,312 @@
+#include <qsox/SocketFilter.hpp>
+
+namespace qsox {
+
+std::string_view SocketFilterError::message() const {
+    switch (m_code) {
+        case TooManyInstructions:
+            return "Filter program is too long";
+        case InvalidRange:
+            return "Invalid port range";
+    }
+
+    qsox::unreachable();
+}
+
+// Classic BPF encoding, defined here as the builder is available on every platform
+namespace bpf {
+    constexpr uint16_t LD = 0x00;
+    constexpr uint16_t ALU = 0x04;
+    constexpr uint16_t JMP = 0x05;
+    constexpr uint16_t RET = 0x06;
+
+    constexpr uint16_t W = 0x00;
+    constexpr uint16_t H = 0x08;
+    constexpr uint16_t B = 0x10;
+
+    constexpr uint16_t ABS = 0x20;
+    constexpr uint16_t LEN = 0x80;
+
+    constexpr uint16_t AND = 0x50;
+    constexpr uint16_t RSH = 0x70;
+
+    constexpr uint16_t JA = 0x00;
+    constexpr uint16_t JEQ = 0x10;
+    constexpr uint16_t JGT = 0x20;
+    constexpr uint16_t JGE = 0x30;
+
+    // Negative offset that makes absolute loads relative to the network (IP) header (SKF_NET_OFF)
+    constexpr uint32_t NetOffset = static_cast<uint32_t>(-0x100000);
+
+    constexpr size_t UdpHeaderSize = 8;
+
+    constexpr uint32_t Accept = 0xffffffff;
+    constexpr uint32_t Drop = 0;
+}
+
+namespace {
+
+// Emits instructions and resolves forward jumps.
+// Conditional jumps only have 8-bit offsets, so every rule is kept self-contained (with its own `ret #0`),
+// and jumps over arbitrary amounts of rules are done with `ja`, which has a 32-bit offset.
+class Emitter {
+public:
+    std::vector<SocketFilterInstruction> code;
+
+    void stmt(uint16_t op, uint32_t k) {
+        code.push_back({op, 0, 0, k});
+    }
+
+    void jump(uint16_t op, uint32_t k, uint8_t jt, uint8_t jf) {
+        code.push_back({static_cast<uint16_t>(bpf::JMP | op), jt, jf, k});
+    }
+
+    void loadNet(uint16_t size, uint32_t offset) {
+        this->stmt(bpf::LD | size | bpf::ABS, bpf::NetOffset + offset);
+    }
+
+    void ret(uint32_t value) {
+        this->stmt(bpf::RET, value);
+    }
+
+    // Emits an unconditional jump with an unresolved target, returns its index for `resolve`
+    size_t forwardJump() {
+        this->jump(bpf::JA, 0, 0, 0);
+        return code.size() - 1;
+    }
+
+    // Points the jump at `index` to the next instruction that will be emitted
+    void resolve(size_t index) {
+        code[index].k = static_cast<uint32_t>(code.size() - index - 1);
+    }
+};
+
+// Emits a check of the source address against `network`.
+// If it matches, either drops the packet (`allowJumps` is null) or jumps past the allow list, recording the jump.
+void emitSourceMatch(Emitter& e, const IpNetwork& network, std::vector<size_t>* allowJumps) {
+    auto emitMatched = [&] {
+        if (allowJumps) {
+            allowJumps->push_back(e.forwardJump());
+        } else {
+            e.ret(bpf::Drop);
+        }
+    };
+
+    if (network.prefixLength() == 0) {
+        emitMatched();
+        return;
+    }
+
+    // compare the address word by word, masking the last partially covered word
+    std::vector<std::pair<uint32_t, uint32_t>> words; // (value, mask)
+    uint32_t addressOffset;
+
+    if (network.isV4()) {
+        auto& net = network.asV4();
+        words.emplace_back(net.address().toBits(), net.netmask().toBits());
+        addressOffset = 12;
+    } else {
+        auto& net = network.asV6();
+        auto& octets = net.address().octets();
+        auto mask = net.netmask().octets();
+
+        for (size_t i = 0; i < 4 && i * 32 < net.prefixLength(); i++) {
+            auto word = [&](const std::array<uint8_t, 16>& a) {
+                return uint32_t(a[i * 4]) << 24 | uint32_t(a[i * 4 + 1]) << 16 | uint32_t(a[i * 4 + 2]) << 8 | a[i * 4 + 3];
+            };
+
+            words.emplace_back(word(octets), word(mask));
+        }
+
+        addressOffset = 8;
+    }
+
+    // every mismatch skips to the instruction after the match action
+    std::vector<size_t> mismatchJumps;
+
+    for (size_t i = 0; i < words.size(); i++) {
+        auto [value, mask] = words[i];
+
+        e.loadNet(bpf::W, addressOffset + static_cast<uint32_t>(i * 4));
+        if (mask != 0xffffffff) {
+            e.stmt(bpf::ALU | bpf::AND, mask);
+        }
+
+        e.jump(bpf::JEQ, value, 0, 0);
+        mismatchJumps.push_back(e.code.size() - 1);
+    }
+
+    emitMatched();
+
+    for (size_t index : mismatchJumps) {
+        e.code[index].jf = static_cast<uint8_t>(e.code.size() - index - 1);
+    }
+}
+
+} // namespace
+
+SocketFilterBuilder& SocketFilterBuilder::denySource(const IpNetwork& network) {
+    m_deniedSources.push_back(network);
+    return *this;
+}
+
+SocketFilterBuilder& SocketFilterBuilder::allowSource(const IpNetwork& network) {
+    m_allowedSources.push_back(network);
+    return *this;
+}
+
+SocketFilterBuilder& SocketFilterBuilder::denySourcePorts(uint16_t first, uint16_t last) {
+    m_invalidRange |= first > last;
+    m_deniedPorts.push_back({first, last});
+    return *this;
+}
+
+SocketFilterBuilder& SocketFilterBuilder::allowSourcePorts(uint16_t first, uint16_t last) {
+    m_invalidRange |= first > last;
+    m_allowedPorts.push_back({first, last});
+    return *this;
+}
+
+SocketFilterBuilder& SocketFilterBuilder::minPayloadLength(uint16_t length) {
+    m_minPayload = length;
+    return *this;
+}
+
+SocketFilterBuilder& SocketFilterBuilder::maxPayloadLength(uint16_t length) {
+    m_maxPayload = length;
+    return *this;
+}
+
+SocketFilterBuilder& SocketFilterBuilder::requirePayloadBytes(const void* bytes, size_t size, uint16_t offset) {
+    auto data = static_cast<const uint8_t*>(bytes);
+    m_payloadBytes.push_back({offset, std::vector<uint8_t>(data, data + size)});
+    return *this;
+}
+
+Result<SocketFilter, SocketFilterError> SocketFilterBuilder::build() const {
+    if (m_invalidRange) {
+        return Err(SocketFilterError::InvalidRange);
+    }
+
+    Emitter e;
+
+    // cheapest checks first, the packet length is known without touching the data
+
+    if (m_minPayload > 0 || m_maxPayload < UINT16_MAX) {
+        e.stmt(bpf::LD | bpf::W | bpf::LEN, 0);
+
+        if (m_minPayload > 0) {
+            e.jump(bpf::JGE, m_minPayload + bpf::UdpHeaderSize, 1, 0);
+            e.ret(bpf::Drop);
+        }
+
+        if (m_maxPayload < UINT16_MAX) {
+            e.jump(bpf::JGT, m_maxPayload + bpf::UdpHeaderSize, 0, 1);
+            e.ret(bpf::Drop);
+        }
+    }
+
+    // loads past the end of the packet make the program return 0, so short packets are dropped here too
+    for (auto& required : m_payloadBytes) {
+        size_t i = 0;
+
+        while (i < required.bytes.size()) {
+            size_t remaining = required.bytes.size() - i;
+            size_t width = remaining >= 4 ? 4 : remaining >= 2 ? 2 : 1;
+            uint16_t size = width == 4 ? bpf::W : width == 2 ? bpf::H : bpf::B;
+
+            uint32_t value = 0;
+            for (size_t j = 0; j < width; j++) {
+                value = value << 8 | required.bytes[i + j];
+            }
+
+            e.stmt(bpf::LD | size | bpf::ABS, static_cast<uint32_t>(bpf::UdpHeaderSize + required.offset + i));
+            e.jump(bpf::JEQ, value, 1, 0);
+            e.ret(bpf::Drop);
+
+            i += width;
+        }
+    }
+
+    // source port is the first field of both the UDP and the TCP header
+
+    if (!m_deniedPorts.empty() || !m_allowedPorts.empty()) {
+        e.stmt(bpf::LD | bpf::H | bpf::ABS, 0);
+
+        for (auto& range : m_deniedPorts) {
+            e.jump(bpf::JGE, range.first, 0, 2);
+            e.jump(bpf::JGT, range.last, 1, 0);
+            e.ret(bpf::Drop);
+        }
+
+        if (!m_allowedPorts.empty()) {
+            std::vector<size_t> allowed;
+
+            for (auto& range : m_allowedPorts) {
+                e.jump(bpf::JGE, range.first, 0, 2);
+                e.jump(bpf::JGT, range.last, 1, 0);
+                allowed.push_back(e.forwardJump());
+            }
+
+            e.ret(bpf::Drop);
+
+            for (size_t index : allowed) {
+                e.resolve(index);
+            }
+        }
+    }
+
+    // source address rules, split by the IP version of the packet
+
+    if (!m_deniedSources.empty() || !m_allowedSources.empty()) {
+        auto emitFamily = [&](bool v6) {
+            for (auto& network : m_deniedSources) {
+                if (network.isV6() == v6) {
+                    emitSourceMatch(e, network, nullptr);
+                }
+            }
+
+            if (m_allowedSources.empty()) {
+                return;
+            }
+
+            std::vector<size_t> allowed;
+
+            for (auto& network : m_allowedSources) {
+                if (network.isV6() == v6) {
+                    emitSourceMatch(e, network, &allowed);
+                }
+            }
+
+            e.ret(bpf::Drop);
+
+            for (size_t index : allowed) {
+                e.resolve(index);
+            }
+        };
+
+        // version is the high nibble of the first byte of both IPv4 and IPv6 headers
+        e.loadNet(bpf::B, 0);
+        e.stmt(bpf::ALU | bpf::RSH, 4);
+        e.jump(bpf::JEQ, 6, 0, 1);
+        size_t toV6 = e.forwardJump();
+
+        emitFamily(false);
+        size_t toEnd = e.forwardJump();
+
+        e.resolve(toV6);
+        emitFamily(true);
+
+        e.resolve(toEnd);
+    }
+
+    e.ret(bpf::Accept);
+
+    if (e.code.size() > SocketFilter::MaxInstructions) {
+        return Err(SocketFilterError::TooManyInstructions);
+    }
+
+    return Ok(SocketFilter(std::move(e.code)));
+}
+
+} // namespace qsox
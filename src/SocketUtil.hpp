@@ -1,6 +1,7 @@
 #pragma once
 
 #include <qsox/SocketAddress.hpp>
+#include <qsox/CompactSocketAddress.hpp>
 #include <qsox/IpAddress.hpp>
 #include <qsox/Util.hpp>
 #include <qsox/BaseSocket.hpp>
@@ -112,6 +113,27 @@ union SockAddrAny {
         *this = addr;
     }
 
+    // Address and port bytes are copied as they are, both are in network byte order in either representation
+    SockAddrAny& operator=(const CompactSocketAddress& addr) {
+        memset((void*) this, 0, sizeof(SockAddrAny));
+
+        if (addr.isV4()) {
+            v4.sin_family = AF_INET;
+            memcpy(&v4.sin_addr, addr.data() + 2, 4);
+            memcpy(&v4.sin_port, addr.data() + 18, 2);
+        } else {
+            v6.sin6_family = AF_INET6;
+            memcpy(&v6.sin6_addr, addr.data() + 2, 16);
+            memcpy(&v6.sin6_port, addr.data() + 18, 2);
+        }
+
+        return *this;
+    }
+
+    SockAddrAny(const CompactSocketAddress& addr) {
+        *this = addr;
+    }
+
     // Accessors / converters
 
     size_t size() const {
@@ -158,6 +180,10 @@ union SockAddrAny {
         return SocketAddressV6::fromSockAddr(v6);
     }
 
+    CompactSocketAddress toCompactSocketAddress() const {
+        return CompactSocketAddress::fromSockAddr(*this->asSockaddr());
+    }
+
     SocketAddress toSocketAddress() const {
         if (family() == AF_INET) {
             return toSocketAddressV4();
@@ -228,7 +254,14 @@ inline NetResult<BaseSocket::SockFd> newSocket(int family, int type, int protoco
     return Ok(sock);
 }
 
-inline NetResult<BaseSocket::SockFd> newBoundSocket(const SocketAddress& address, int type, int protocol = 0) {
+// If `reusePort` is true, sets SO_REUSEPORT so that multiple sockets can bind to the same address
+inline NetResult<BaseSocket::SockFd> newBoundSocket(const SocketAddress& address, int type, int protocol = 0, bool reusePort = false) {
+#ifndef SO_REUSEPORT
+    if (reusePort) {
+        return Err(Error::Unimplemented);
+    }
+#endif
+
     auto newRes = newSocket(address.family(), type, protocol);
     if (!newRes) {
         return Err(newRes.unwrapErr());
@@ -238,6 +271,16 @@ inline NetResult<BaseSocket::SockFd> newBoundSocket(const SocketAddress& address
 
     SockAddrAny addrStorage = address;
 
+#ifdef SO_REUSEPORT
+    if (reusePort) {
+        int enable = 1;
+        if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, reinterpret_cast<const char*>(&enable), sizeof(enable)) < 0) {
+            qsox::closeSocket(sock);
+            return Err(Error::lastOsError());
+        }
+    }
+#endif
+
     // explicitly disable v6 only mode for v6 sockets
 #ifdef IPV6_V6ONLY
     if (address.isV6()) {
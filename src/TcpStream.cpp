@@ -1,5 +1,7 @@
 #include <qsox/TcpStream.hpp>
+#include <qsox/Poll.hpp>
 #include "SocketUtil.hpp"
+#include <limits.h>
 
 namespace qsox {
 
@@ -29,8 +31,45 @@ NetResult<TcpStream> TcpStream::connectInternal(const SocketAddress& address, bo
     return Ok(std::move(stream));
 }
 
+#ifdef MSG_DONTWAIT
+static constexpr int DontWaitFlag = MSG_DONTWAIT;
+#else
+static constexpr int DontWaitFlag = 0;
+#endif
+
+static bool isInterrupted(const Error& err) {
+#ifdef _WIN32
+    return false;
+#else
+    return err.isOsError() && err.osCode() == EINTR;
+#endif
+}
+
+// Waits until the socket is ready, fails with `TimedOut` if the deadline passes first
+static NetResult<> waitUntil(BaseSocket& socket, PollType type, TcpStream::Deadline deadline) {
+    auto remaining = deadline - std::chrono::steady_clock::now();
+    if (remaining <= remaining.zero()) {
+        return Err(Error::TimedOut);
+    }
+
+    // rounded up, so the wait doesn't end just before the deadline
+    auto ms = std::chrono::ceil<std::chrono::milliseconds>(remaining).count();
+
+    GEODE_UNWRAP_INTO(auto result, pollOne(socket, type, static_cast<int>(std::min<int64_t>(ms, INT_MAX))));
+
+    if (result == PollResult::Timeout) {
+        return Err(Error::TimedOut);
+    }
+
+    return Ok();
+}
+
 NetResult<size_t> TcpStream::send(const void* data, size_t size) {
-    auto res = ::send(m_fd, reinterpret_cast<const char*>(data), size, sendFlags());
+    return this->_send(data, size, sendFlags());
+}
+
+NetResult<size_t> TcpStream::_send(const void* data, size_t size, int flags) {
+    auto res = ::send(m_fd, reinterpret_cast<const char*>(data), size, flags);
     if (res < 0) {
         return Err(Error::lastOsError());
     } else if (res == 0) {
@@ -41,27 +80,55 @@ NetResult<size_t> TcpStream::send(const void* data, size_t size) {
 }
 
 NetResult<> TcpStream::sendAll(const void* data, size_t size) {
+    TransferCursor cursor;
+    return this->sendAll(data, size, cursor);
+}
+
+NetResult<> TcpStream::sendAll(const void* data, size_t size, TransferCursor& cursor) {
     const char* ptr = static_cast<const char*>(data);
-    size_t remaining = size;
 
-    while (remaining > 0) {
-        auto result = this->send(ptr, remaining);
+    while (cursor.transferred < size) {
+        auto result = this->send(ptr + cursor.transferred, size - cursor.transferred);
         if (result.isErr()) {
             auto err = result.unwrapErr();
-#ifdef _WIN32
+            if (isInterrupted(err)) {
+                continue; // retry on EINTR
+            }
+
             return Err(err);
-#else
-            if (!err.isOsError() || err.osCode() != EINTR) return Err(result.unwrapErr());
-            continue; // retry on EINTR
-#endif
         }
 
-        size_t sent = result.unwrap();
+        cursor.transferred += result.unwrap();
+    }
+
+    return Ok();
+}
+
+NetResult<> TcpStream::sendAll(const void* data, size_t size, Deadline deadline) {
+    const char* ptr = static_cast<const char*>(data);
+    size_t remaining = size;
 
-        if (sent == 0) {
-            return Err(Error::ConnectionClosed);
+    while (remaining > 0) {
+        if constexpr (DontWaitFlag == 0) {
+            // without a non-blocking flag, wait before every send so that it doesn't block past the deadline
+            GEODE_UNWRAP(waitUntil(*this, PollType::Write, deadline));
         }
 
+        auto result = this->_send(ptr, remaining, sendFlags() | DontWaitFlag);
+        if (result.isErr()) {
+            auto err = result.unwrapErr();
+
+            if (err == Error::WouldBlock) {
+                GEODE_UNWRAP(waitUntil(*this, PollType::Write, deadline));
+                continue;
+            } else if (isInterrupted(err)) {
+                continue;
+            }
+
+            return Err(err);
+        }
+
+        size_t sent = result.unwrap();
         ptr += sent;
         remaining -= sent;
     }
@@ -74,27 +141,54 @@ NetResult<size_t> TcpStream::receive(void* buffer, size_t size) {
 }
 
 NetResult<> TcpStream::receiveExact(void* buffer, size_t size) {
+    TransferCursor cursor;
+    return this->receiveExact(buffer, size, cursor);
+}
+
+NetResult<> TcpStream::receiveExact(void* buffer, size_t size, TransferCursor& cursor) {
     char* ptr = static_cast<char*>(buffer);
-    size_t remaining = size;
 
-    while (remaining > 0) {
-        auto result = this->receive(ptr, remaining);
+    while (cursor.transferred < size) {
+        auto result = this->receive(ptr + cursor.transferred, size - cursor.transferred);
         if (result.isErr()) {
             auto err = result.unwrapErr();
-#ifdef _WIN32
+            if (isInterrupted(err)) {
+                continue; // retry on EINTR
+            }
+
             return Err(err);
-#else
-            if (!err.isOsError() || err.osCode() != EINTR) return Err(result.unwrapErr());
-            continue; // retry on EINTR
-#endif
         }
 
-        size_t received = result.unwrap();
+        cursor.transferred += result.unwrap();
+    }
+
+    return Ok();
+}
 
-        if (received == 0) {
-            return Err(Error::ConnectionClosed);
+NetResult<> TcpStream::receiveExact(void* buffer, size_t size, Deadline deadline) {
+    char* ptr = static_cast<char*>(buffer);
+    size_t remaining = size;
+
+    while (remaining > 0) {
+        if constexpr (DontWaitFlag == 0) {
+            GEODE_UNWRAP(waitUntil(*this, PollType::Read, deadline));
         }
 
+        auto result = this->_receive(ptr, remaining, recvFlags() | DontWaitFlag);
+        if (result.isErr()) {
+            auto err = result.unwrapErr();
+
+            if (err == Error::WouldBlock) {
+                GEODE_UNWRAP(waitUntil(*this, PollType::Read, deadline));
+                continue;
+            } else if (isInterrupted(err)) {
+                continue;
+            }
+
+            return Err(err);
+        }
+
+        size_t received = result.unwrap();
         ptr += received;
         remaining -= received;
     }
@@ -0,0 +1,77 @@
+#include <qsox/UdpListener.hpp>
+#include "SocketUtil.hpp"
+
+#ifdef __linux__
+# include <linux/filter.h>
+#endif
+
+namespace qsox {
+
+UdpListener::UdpListener(UdpSocket socket, const SocketAddress& localAddress)
+    : m_socket(std::move(socket)), m_localAddress(localAddress) {}
+
+NetResult<UdpListener> UdpListener::bind(const SocketAddress& address) {
+    GEODE_UNWRAP_INTO(auto socket, UdpSocket::bind(address, true));
+    GEODE_UNWRAP_INTO(auto localAddress, socket.localAddress());
+
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+    // Datagrams that match no connected socket go to the group member picked by this program.
+    // Always picking the first one (the listener) keeps peer sockets from receiving other peers' datagrams
+    // between binding and connecting.
+    sock_filter code[] = {
+        {BPF_RET | BPF_K, 0, 0, 0},
+    };
+
+    sock_fprog program = {};
+    program.len = 1;
+    program.filter = code;
+
+    GEODE_UNWRAP(mapResult(setsockopt(socket.handle(), SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program))));
+#endif
+
+    return Ok(UdpListener(std::move(socket), localAddress));
+}
+
+NetResult<UdpAccepted> UdpListener::accept(void* buffer, size_t size) {
+    while (true) {
+        SocketAddress peer;
+        GEODE_UNWRAP_INTO(size_t received, m_socket.recvFrom(buffer, size, peer));
+
+        if (!m_peers.insert(peer)) {
+            // sent before the peer socket was connected, see the comment in the header
+            continue;
+        }
+
+        auto socket = this->connectPeer(peer);
+        if (!socket) {
+            m_peers.erase(peer);
+            return Err(socket.unwrapErr());
+        }
+
+        return Ok(UdpAccepted{std::move(socket).unwrap(), peer, received});
+    }
+}
+
+NetResult<UdpSocket> UdpListener::connectPeer(const SocketAddress& peer) {
+    GEODE_UNWRAP_INTO(auto socket, UdpSocket::bind(m_localAddress, true));
+    GEODE_UNWRAP(socket.connect(peer));
+    return Ok(std::move(socket));
+}
+
+bool UdpListener::release(const SocketAddress& peer) {
+    return m_peers.erase(peer);
+}
+
+size_t UdpListener::peerCount() const {
+    return m_peers.size();
+}
+
+SocketAddress UdpListener::localAddress() const {
+    return m_localAddress;
+}
+
+UdpSocket& UdpListener::socket() {
+    return m_socket;
+}
+
+} // namespace qsox
@@ -0,0 +1,71 @@
+#include <qsox/UdpPeerTable.hpp>
+#include <cassert>
+
+namespace qsox {
+
+std::pair<uint32_t, bool> UdpPeerTable::intern(const UdpDestination& peer) {
+    auto [it, inserted] = m_ids.tryEmplace(peer.compactAddress(), InvalidId);
+    if (!inserted) {
+        return {it->second, false};
+    }
+
+    uint32_t id;
+    if (!m_freeIds.empty()) {
+        id = m_freeIds.back();
+        m_freeIds.pop_back();
+        m_peers[id] = peer;
+    } else {
+        id = static_cast<uint32_t>(m_peers.size());
+        m_peers.push_back(peer);
+    }
+
+    it->second = id;
+    return {id, true};
+}
+
+uint32_t UdpPeerTable::find(const UdpDestination& peer) const {
+    auto id = m_ids.get(peer.compactAddress());
+    return id ? *id : InvalidId;
+}
+
+bool UdpPeerTable::remove(uint32_t id) {
+    if (!this->contains(id)) {
+        return false;
+    }
+
+    m_ids.erase(m_peers[id].compactAddress());
+    m_peers[id] = UdpDestination{};
+    m_freeIds.push_back(id);
+
+    return true;
+}
+
+bool UdpPeerTable::contains(uint32_t id) const {
+    return id < m_peers.size() && m_peers[id].m_size != 0;
+}
+
+const UdpDestination& UdpPeerTable::destination(uint32_t id) const {
+    assert(this->contains(id) && "Peer ID not in use");
+    return m_peers[id];
+}
+
+size_t UdpPeerTable::size() const {
+    return m_ids.size();
+}
+
+size_t UdpPeerTable::idLimit() const {
+    return m_peers.size();
+}
+
+void UdpPeerTable::reserve(size_t count) {
+    m_ids.reserve(count);
+    m_peers.reserve(count);
+}
+
+void UdpPeerTable::clear() {
+    m_ids.clear();
+    m_peers.clear();
+    m_freeIds.clear();
+}
+
+} // namespace qsox
@@ -0,0 +1,231 @@
+#include <qsox/UdpRateLimiter.hpp>
+#include <qsox/AddressMap.hpp>
+#include <qsox/IpNetwork.hpp>
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace qsox {
+
+static constexpr uint64_t NsPerSecond = 1'000'000'000;
+static constexpr uint32_t NoEntry = UINT32_MAX;
+
+namespace {
+
+struct Entry {
+    CompactSocketAddress key;
+    int64_t full; // time at which the bucket is full again (GCRA theoretical arrival time)
+    uint32_t prev;
+    uint32_t next;
+};
+
+} // namespace
+
+// Aligned to keep the locks of neighbouring shards on separate cache lines
+struct alignas(64) UdpRateLimiter::Shard {
+    std::mutex mutex;
+    AddressMap<CompactSocketAddress, uint32_t> index;
+    std::vector<Entry> entries; // LRU list, `head` is the most recently seen source
+    uint32_t head = NoEntry;
+    uint32_t tail = NoEntry;
+    size_t capacity = 0;
+
+    uint64_t allowed = 0;
+    uint64_t limited = 0;
+    uint64_t evicted = 0;
+
+    void unlink(uint32_t idx) {
+        auto& e = entries[idx];
+
+        if (e.prev != NoEntry) entries[e.prev].next = e.next;
+        else head = e.next;
+
+        if (e.next != NoEntry) entries[e.next].prev = e.prev;
+        else tail = e.prev;
+    }
+
+    void pushFront(uint32_t idx) {
+        auto& e = entries[idx];
+        e.prev = NoEntry;
+        e.next = head;
+
+        if (head != NoEntry) entries[head].prev = idx;
+        head = idx;
+
+        if (tail == NoEntry) tail = idx;
+    }
+
+    // Returns the entry of the source, creating it (with a full bucket) if needed
+    Entry& touch(const CompactSocketAddress& key, int64_t now) {
+        if (auto idx = index.get(key)) {
+            if (head != *idx) {
+                this->unlink(*idx);
+                this->pushFront(*idx);
+            }
+
+            return entries[*idx];
+        }
+
+        uint32_t idx;
+        if (entries.size() < capacity) {
+            idx = static_cast<uint32_t>(entries.size());
+            entries.push_back({});
+        } else {
+            idx = tail;
+            this->unlink(idx);
+            index.erase(entries[idx].key);
+            evicted++;
+        }
+
+        entries[idx].key = key;
+        entries[idx].full = now;
+        index.insert(key, idx);
+        this->pushFront(idx);
+
+        return entries[idx];
+    }
+};
+
+UdpRateLimiter::UdpRateLimiter(const UdpRateLimiterOptions& options) : m_options(options) {
+    m_options.rate = std::max<uint64_t>(m_options.rate, 1);
+
+    m_shardCount = 1;
+    m_shardShift = 64;
+    while (m_shardCount < options.shards) {
+        m_shardCount *= 2;
+        m_shardShift--;
+    }
+
+    m_shards = std::make_unique<Shard[]>(m_shardCount);
+
+    size_t perShard = std::max<size_t>((options.maxSources + m_shardCount - 1) / m_shardCount, 1);
+    for (size_t i = 0; i < m_shardCount; i++) {
+        m_shards[i].capacity = perShard;
+    }
+
+    // rounded up, so that a full burst always fits
+    uint64_t burst = m_options.burst;
+    uint64_t rate = m_options.rate;
+    m_tolerance = static_cast<int64_t>(burst / rate * NsPerSecond + (burst % rate * NsPerSecond + rate - 1) / rate);
+}
+
+UdpRateLimiter::~UdpRateLimiter() = default;
+
+CompactSocketAddress UdpRateLimiter::keyFor(const IpAddress& source) const {
+    if (source.isV4()) {
+        return SocketAddressV4{Ipv4Network{source.asV4(), m_options.ipv4Prefix}.address()};
+    }
+
+    if (auto v4 = source.asV6().toIpv4Mapped()) {
+        return SocketAddressV4{Ipv4Network{*v4, m_options.ipv4Prefix}.address()};
+    }
+
+    return SocketAddressV6{Ipv6Network{source.asV6(), m_options.ipv6Prefix}.address()};
+}
+
+int64_t UdpRateLimiter::costFor(uint64_t cost) const {
+    uint64_t rate = m_options.rate;
+    return static_cast<int64_t>(cost / rate * NsPerSecond + cost % rate * NsPerSecond / rate);
+}
+
+bool UdpRateLimiter::allow(const IpAddress& source, uint64_t cost, TimePoint now) {
+    auto key = this->keyFor(source);
+
+    // the top bits pick the shard, the table inside the shard uses the low ones
+    uint64_t hash = std::hash<CompactSocketAddress>{}(key);
+    auto& shard = m_shards[m_shardShift == 64 ? 0 : hash >> m_shardShift];
+
+    int64_t nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+    int64_t costNs = this->costFor(cost);
+
+    std::lock_guard lock(shard.mutex);
+
+    auto& entry = shard.touch(key, nowNs);
+    int64_t full = std::max(entry.full, nowNs) + costNs;
+
+    if (full - m_tolerance > nowNs) {
+        shard.limited++;
+        return false;
+    }
+
+    entry.full = full;
+    shard.allowed++;
+    return true;
+}
+
+bool UdpRateLimiter::allow(const UdpDestination& source, uint64_t cost, TimePoint now) {
+    return this->allow(source.address().address(), cost, now);
+}
+
+size_t UdpRateLimiter::filter(UdpBatchBuffer* buffers, size_t count, TimePoint now) {
+    size_t kept = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (!this->allow(buffers[i].sender, 1, now)) {
+            continue;
+        }
+
+        if (kept != i) {
+            std::swap(buffers[kept], buffers[i]);
+        }
+
+        kept++;
+    }
+
+    return kept;
+}
+
+NetResult<size_t> UdpRateLimiter::recvFrom(UdpSocket& socket, void* buffer, size_t size, UdpDestination& sender) {
+    while (true) {
+        GEODE_UNWRAP_INTO(size_t received, socket.recvFrom(buffer, size, sender));
+
+        if (this->allow(sender)) {
+            return Ok(received);
+        }
+    }
+}
+
+NetResult<size_t> UdpRateLimiter::recvBatch(UdpSocket& socket, UdpBatchBuffer* buffers, size_t count) {
+    if (count == 0) {
+        return Ok(0);
+    }
+
+    while (true) {
+        GEODE_UNWRAP_INTO(size_t received, socket.recvBatch(buffers, count));
+
+        size_t kept = this->filter(buffers, received);
+        if (kept > 0) {
+            return Ok(kept);
+        }
+    }
+}
+
+UdpRateLimiterStats UdpRateLimiter::stats() const {
+    UdpRateLimiterStats stats;
+
+    for (size_t i = 0; i < m_shardCount; i++) {
+        auto& shard = m_shards[i];
+        std::lock_guard lock(shard.mutex);
+
+        stats.allowed += shard.allowed;
+        stats.limited += shard.limited;
+        stats.evicted += shard.evicted;
+        stats.sources += shard.entries.size();
+    }
+
+    return stats;
+}
+
+void UdpRateLimiter::clear() {
+    for (size_t i = 0; i < m_shardCount; i++) {
+        auto& shard = m_shards[i];
+        std::lock_guard lock(shard.mutex);
+
+        shard.index.clear();
+        shard.entries.clear();
+        shard.head = NoEntry;
+        shard.tail = NoEntry;
+    }
+}
+
+} // namespace qsox
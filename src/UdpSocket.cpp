@@ -24,8 +24,8 @@ static SockAddrAny constructDestAddr(const SocketAddress& address, bool ipv6) {
 
 UdpSocket::UdpSocket(SockFd fd) : BaseSocket(fd) {}
 
-NetResult<UdpSocket> UdpSocket::bind(const SocketAddress& address) {
-    return qsox::newBoundSocket(address, SOCK_DGRAM).map([&](SockFd fd) {
+NetResult<UdpSocket> UdpSocket::bind(const SocketAddress& address, bool reusePort) {
+    return qsox::newBoundSocket(address, SOCK_DGRAM, 0, reusePort).map([&](SockFd fd) {
         UdpSocket sock{fd};
         sock.ipv6 = address.isV6();
         return sock;
@@ -55,6 +55,468 @@ NetResult<size_t> UdpSocket::sendTo(const void* buffer, size_t size, const Socke
     return this->_sendTo(buffer, size, destination, sendFlags());
 }
 
+static_assert(sizeof(SockAddrAny) <= UdpDestination::MaxNativeSize);
+
+SocketAddress UdpDestination::address() const {
+    SockAddrAny sa;
+    memcpy((void*) &sa, m_storage, sizeof(sa));
+
+    auto addr = sa.toSocketAddress();
+
+    // undo the conversion done in `constructDestAddr`
+    if (m_mapped) {
+        return SocketAddressV4{*addr.toV6().address().toIpv4Mapped(), addr.port()};
+    }
+
+    return addr;
+}
+
+CompactSocketAddress UdpDestination::compactAddress() const {
+    auto addr = CompactSocketAddress::fromSockAddr(*reinterpret_cast<const sockaddr*>(m_storage));
+
+    // IPv4 peers are received IPv4-mapped on dual stack sockets, fold them into plain IPv4
+    // so that they get the same key as destinations prepared from an IPv4 address
+    static constexpr uint8_t MappedPrefix[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+
+    if (addr.isV6() && memcmp(addr.data() + 2, MappedPrefix, sizeof(MappedPrefix)) == 0) {
+        const uint8_t* v4 = addr.data() + 14;
+        return SocketAddressV4{Ipv4Address{v4[0], v4[1], v4[2], v4[3]}, addr.port()};
+    }
+
+    return addr;
+}
+
+UdpDestination UdpSocket::prepareDestination(const SocketAddress& address) const {
+    SockAddrAny sa = constructDestAddr(address, this->ipv6);
+
+    UdpDestination dest;
+    memcpy(dest.m_storage, &sa, sizeof(sa));
+    dest.m_size = static_cast<uint32_t>(sa.size());
+    dest.m_mapped = address.isV4() && sa.family() == AF_INET6;
+    return dest;
+}
+
+NetResult<size_t> UdpSocket::sendTo(const void* buffer, size_t size, const UdpDestination& destination) {
+    auto sent = ::sendto(m_fd, static_cast<const char*>(buffer), size, sendFlags(),
+                          reinterpret_cast<const sockaddr*>(destination.m_storage), destination.m_size);
+
+    if (sent < 0) {
+        return Err(this->_sendError());
+    }
+
+    return Ok(static_cast<size_t>(sent));
+}
+
+NetResult<size_t> UdpSocket::sendToBatch(const UdpBatchMessage* messages, size_t count) {
+    size_t done = 0;
+
+#ifdef __linux__
+    // submitted in chunks, to keep the kernel structures on the stack
+    constexpr size_t ChunkSize = 64;
+    mmsghdr headers[ChunkSize];
+    iovec iovecs[ChunkSize];
+
+# ifdef SCM_TXTIME
+    // departure times for SO_TXTIME, attached only to the messages that have one
+    union TxTimeControl {
+        cmsghdr align;
+        char data[CMSG_SPACE(sizeof(uint64_t))];
+    };
+    TxTimeControl controls[ChunkSize];
+# endif
+
+    while (done < count) {
+        size_t chunk = std::min(count - done, ChunkSize);
+
+        for (size_t i = 0; i < chunk; i++) {
+            auto& msg = messages[done + i];
+
+            iovecs[i].iov_base = const_cast<void*>(msg.data);
+            iovecs[i].iov_len = msg.size;
+
+            headers[i] = {};
+            headers[i].msg_hdr.msg_name = const_cast<uint8_t*>(msg.destination->m_storage);
+            headers[i].msg_hdr.msg_namelen = msg.destination->m_size;
+            headers[i].msg_hdr.msg_iov = &iovecs[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+
+# ifdef SCM_TXTIME
+            if (msg.txTime.count() != 0) {
+                uint64_t time = static_cast<uint64_t>(msg.txTime.count());
+                memset(&controls[i], 0, sizeof(TxTimeControl));
+
+                headers[i].msg_hdr.msg_control = controls[i].data;
+                headers[i].msg_hdr.msg_controllen = sizeof(controls[i].data);
+
+                cmsghdr* cmsg = CMSG_FIRSTHDR(&headers[i].msg_hdr);
+                cmsg->cmsg_level = SOL_SOCKET;
+                cmsg->cmsg_type = SCM_TXTIME;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(time));
+                memcpy(CMSG_DATA(cmsg), &time, sizeof(time));
+            }
+# endif
+        }
+
+        int sent = ::sendmmsg(m_fd, headers, static_cast<unsigned int>(chunk), sendFlags());
+        if (sent < 0) {
+            if (done == 0) {
+                return Err(this->_sendError());
+            }
+
+            break;
+        }
+
+        done += static_cast<size_t>(sent);
+
+        if (static_cast<size_t>(sent) < chunk) {
+            break;
+        }
+    }
+#else
+    for (; done < count; done++) {
+        auto& msg = messages[done];
+        auto res = msg.txTime.count() != 0
+            ? this->sendAt(msg.data, msg.size, *msg.destination, msg.txTime)
+            : this->sendTo(msg.data, msg.size, *msg.destination);
+
+        if (!res) {
+            if (done == 0) {
+                return Err(res.unwrapErr());
+            }
+
+            break;
+        }
+    }
+#endif
+
+    return Ok(done);
+}
+
+NetResult<size_t> UdpSocket::recvBatch(UdpBatchBuffer* buffers, size_t count) {
+    size_t done = 0;
+
+#ifdef __linux__
+    constexpr size_t ChunkSize = 64;
+    mmsghdr headers[ChunkSize];
+    iovec iovecs[ChunkSize];
+
+    while (done < count) {
+        size_t chunk = std::min(count - done, ChunkSize);
+
+        for (size_t i = 0; i < chunk; i++) {
+            auto& buf = buffers[done + i];
+
+            iovecs[i].iov_base = buf.data;
+            iovecs[i].iov_len = buf.size;
+
+            headers[i] = {};
+            headers[i].msg_hdr.msg_name = buf.sender.m_storage;
+            headers[i].msg_hdr.msg_namelen = sizeof(buf.sender.m_storage);
+            headers[i].msg_hdr.msg_iov = &iovecs[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        // only the first call may block
+        int flags = recvFlags() | (done == 0 ? MSG_WAITFORONE : MSG_DONTWAIT);
+        int received = ::recvmmsg(m_fd, headers, static_cast<unsigned int>(chunk), flags, nullptr);
+
+        if (received < 0) {
+            if (done == 0) {
+                return Err(Error::lastOsError());
+            }
+
+            break;
+        }
+
+        for (size_t i = 0; i < static_cast<size_t>(received); i++) {
+            auto& buf = buffers[done + i];
+            buf.received = headers[i].msg_len;
+            buf.sender.m_size = headers[i].msg_hdr.msg_namelen;
+            buf.sender.m_mapped = false;
+        }
+
+        done += static_cast<size_t>(received);
+
+        if (static_cast<size_t>(received) < chunk) {
+            break;
+        }
+    }
+#else
+    for (; done < count; done++) {
+        auto& buf = buffers[done];
+
+# ifdef MSG_DONTWAIT
+        int flags = recvFlags() | (done == 0 ? 0 : MSG_DONTWAIT);
+# else
+        // without MSG_DONTWAIT, only one datagram can be received without risking to block
+        if (done > 0) {
+            break;
+        }
+
+        int flags = recvFlags();
+# endif
+
+        auto res = this->_recvFrom(buf.data, buf.size, buf.sender, flags);
+        if (!res) {
+            if (done == 0) {
+                return Err(res.unwrapErr());
+            }
+
+            break;
+        }
+
+        buf.received = res.unwrap();
+    }
+#endif
+
+    return Ok(done);
+}
+
+// Multicast
+
+#if defined(_WIN32)
+using MulticastV4Option = DWORD;
+#elif defined(__linux__)
+using MulticastV4Option = int;
+#else
+// BSDs only accept a single byte for IPv4 multicast loop and TTL
+using MulticastV4Option = unsigned char;
+#endif
+
+template <typename T>
+static NetResult<> setOption(SockFd fd, int level, int name, const T& value) {
+    return mapResult(setsockopt(fd, level, name, reinterpret_cast<const char*>(&value), sizeof(value)));
+}
+
+static void toSockAddrStorage(const IpAddress& addr, sockaddr_storage& out) {
+    SockAddrAny sa = SocketAddress{addr, 0};
+
+    memset(&out, 0, sizeof(out));
+    memcpy(&out, sa.asSockaddr(), sa.size());
+}
+
+// The options are protocol independent, the level is picked by the group address family
+static NetResult<> changeMembership(SockFd fd, int option, const IpAddress& group, uint32_t interfaceIndex) {
+    group_req req = {};
+    req.gr_interface = interfaceIndex;
+    toSockAddrStorage(group, req.gr_group);
+
+    return setOption(fd, group.isV4() ? IPPROTO_IP : IPPROTO_IPV6, option, req);
+}
+
+static NetResult<> changeSourceMembership(SockFd fd, int option, const IpAddress& group, const IpAddress& source, uint32_t interfaceIndex) {
+    if (group.isV4() != source.isV4()) {
+        return Err(Error::InvalidArgument);
+    }
+
+    group_source_req req = {};
+    req.gsr_interface = interfaceIndex;
+    toSockAddrStorage(group, req.gsr_group);
+    toSockAddrStorage(source, req.gsr_source);
+
+    return setOption(fd, group.isV4() ? IPPROTO_IP : IPPROTO_IPV6, option, req);
+}
+
+NetResult<> UdpSocket::joinMulticast(const IpAddress& group, uint32_t interfaceIndex) {
+    return changeMembership(m_fd, MCAST_JOIN_GROUP, group, interfaceIndex);
+}
+
+NetResult<> UdpSocket::leaveMulticast(const IpAddress& group, uint32_t interfaceIndex) {
+    return changeMembership(m_fd, MCAST_LEAVE_GROUP, group, interfaceIndex);
+}
+
+NetResult<> UdpSocket::joinMulticast(const IpAddress& group, const IpAddress& source, uint32_t interfaceIndex) {
+    return changeSourceMembership(m_fd, MCAST_JOIN_SOURCE_GROUP, group, source, interfaceIndex);
+}
+
+NetResult<> UdpSocket::leaveMulticast(const IpAddress& group, const IpAddress& source, uint32_t interfaceIndex) {
+    return changeSourceMembership(m_fd, MCAST_LEAVE_SOURCE_GROUP, group, source, interfaceIndex);
+}
+
+NetResult<> UdpSocket::setMulticastInterface(uint32_t interfaceIndex) {
+    if (this->ipv6) {
+        GEODE_UNWRAP(setOption(m_fd, IPPROTO_IPV6, IPV6_MULTICAST_IF, static_cast<unsigned int>(interfaceIndex)));
+    }
+
+#ifdef __linux__
+    // also covers IPv4 traffic on dual stack sockets
+    ip_mreqn req = {};
+    req.imr_ifindex = static_cast<int>(interfaceIndex);
+
+    return setOption(m_fd, IPPROTO_IP, IP_MULTICAST_IF, req);
+#else
+    if (!this->ipv6) {
+        return Err(Error::Unimplemented);
+    }
+
+    return Ok();
+#endif
+}
+
+NetResult<> UdpSocket::setMulticastInterface(const Ipv4Address& localAddress) {
+    in_addr addr;
+    localAddress.toInAddr(addr);
+
+    return setOption(m_fd, IPPROTO_IP, IP_MULTICAST_IF, addr);
+}
+
+NetResult<> UdpSocket::setMulticastLoop(bool enable) {
+    if (this->ipv6) {
+        GEODE_UNWRAP(setOption(m_fd, IPPROTO_IPV6, IPV6_MULTICAST_LOOP, static_cast<unsigned int>(enable)));
+
+#ifndef __linux__
+        return Ok();
+#endif
+    }
+
+    return setOption(m_fd, IPPROTO_IP, IP_MULTICAST_LOOP, static_cast<MulticastV4Option>(enable));
+}
+
+NetResult<> UdpSocket::setMulticastTtl(uint8_t ttl) {
+    if (this->ipv6) {
+        GEODE_UNWRAP(setOption(m_fd, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, static_cast<int>(ttl)));
+
+#ifndef __linux__
+        return Ok();
+#endif
+    }
+
+    return setOption(m_fd, IPPROTO_IP, IP_MULTICAST_TTL, static_cast<MulticastV4Option>(ttl));
+}
+
+// Path MTU
+
+NetResult<> UdpSocket::setPathMtuDiscovery(PathMtuDiscovery mode, bool reportErrors) {
+#if !defined(IP_PMTUDISC_WANT) || !defined(IP_RECVERR)
+    if (reportErrors) {
+        return Err(Error::Unimplemented);
+    }
+#endif
+
+#ifdef IP_PMTUDISC_WANT
+    int value = IP_PMTUDISC_WANT;
+    switch (mode) {
+        case PathMtuDiscovery::Dont: value = IP_PMTUDISC_DONT; break;
+        case PathMtuDiscovery::Want: value = IP_PMTUDISC_WANT; break;
+        case PathMtuDiscovery::Do: value = IP_PMTUDISC_DO; break;
+        case PathMtuDiscovery::Probe: value = IP_PMTUDISC_PROBE; break;
+    }
+
+    // the IPv4 option also covers IPv4 traffic on dual stack sockets, and the IPV6_PMTUDISC_* values are the same
+    int res = setsockopt(m_fd, IPPROTO_IP, IP_MTU_DISCOVER, &value, sizeof(value));
+    if (res < 0 && !this->ipv6) {
+        return Err(Error::lastOsError());
+    }
+
+    if (this->ipv6 && setsockopt(m_fd, IPPROTO_IPV6, IPV6_MTU_DISCOVER, &value, sizeof(value)) < 0) {
+        return Err(Error::lastOsError());
+    }
+
+# ifdef IP_RECVERR
+    int recvErr = reportErrors ? 1 : 0;
+
+    res = setsockopt(m_fd, IPPROTO_IP, IP_RECVERR, &recvErr, sizeof(recvErr));
+    if (res < 0 && !this->ipv6) {
+        return Err(Error::lastOsError());
+    }
+
+    if (this->ipv6 && setsockopt(m_fd, IPPROTO_IPV6, IPV6_RECVERR, &recvErr, sizeof(recvErr)) < 0) {
+        return Err(Error::lastOsError());
+    }
+
+    m_mtuErrors = reportErrors;
+# endif
+
+    return Ok();
+#elif defined(IP_DONTFRAG)
+    int value = (mode == PathMtuDiscovery::Do || mode == PathMtuDiscovery::Probe) ? 1 : 0;
+
+    if (this->ipv6) {
+        return mapResult(setsockopt(m_fd, IPPROTO_IPV6, IPV6_DONTFRAG, &value, sizeof(value)));
+    }
+
+    return mapResult(setsockopt(m_fd, IPPROTO_IP, IP_DONTFRAG, &value, sizeof(value)));
+#else
+    return Err(Error::Unimplemented);
+#endif
+}
+
+NetResult<uint32_t> UdpSocket::pathMtu() const {
+#ifdef IP_MTU
+    int mtu = 0;
+    socklen_t len = sizeof(mtu);
+
+    int res = this->ipv6
+        ? getsockopt(m_fd, IPPROTO_IPV6, IPV6_MTU, reinterpret_cast<char*>(&mtu), &len)
+        : getsockopt(m_fd, IPPROTO_IP, IP_MTU, reinterpret_cast<char*>(&mtu), &len);
+
+    if (res < 0) {
+        return Err(Error::lastOsError());
+    }
+
+    return Ok(static_cast<uint32_t>(mtu));
+#else
+    return Err(Error::Unimplemented);
+#endif
+}
+
+NetResult<size_t> UdpSocket::maxPayloadSize() const {
+    GEODE_UNWRAP_INTO(uint32_t mtu, this->pathMtu());
+    GEODE_UNWRAP_INTO(auto remote, this->remoteAddress());
+
+    // IPv4 header without options (20) or IPv6 header (40), and the UDP header (8)
+    bool v4 = remote.isV4() || remote.toV6().address().toIpv4Mapped().has_value();
+    size_t overhead = v4 ? 28 : 48;
+
+    return Ok(mtu > overhead ? mtu - overhead : 0);
+}
+
+Error UdpSocket::_sendError() const {
+    auto err = Error::lastOsError();
+
+    if (err == Error::MessageTooLong) {
+        // pathMtu only works on connected sockets, otherwise the kernel reports the MTU on the error queue
+        // if IP_RECVERR is enabled (this dequeues it even on connected sockets)
+        auto mtu = this->pathMtu();
+        uint32_t queued = m_mtuErrors ? this->_queuedMtu() : 0;
+
+        return Error::messageTooLong(mtu ? mtu.unwrap() : queued);
+    }
+
+    return err;
+}
+
+void UdpSocket::setReceiveBufferAutoTune(size_t maxSize) {
+    m_autoTuneMax = maxSize;
+}
+
+void UdpSocket::_noteDrops(uint64_t drops) {
+    bool increased = drops > m_lastDrops;
+    m_lastDrops = drops;
+
+    if (!increased || m_autoTuneMax == 0) {
+        return;
+    }
+
+    auto reported = this->receiveBufferSize();
+    if (!reported) {
+        return;
+    }
+
+#ifdef __linux__
+    // the reported size is double of what was set
+    size_t current = reported.unwrap() / 2;
+#else
+    size_t current = reported.unwrap();
+#endif
+
+    size_t next = std::min(current * 2, m_autoTuneMax);
+    if (next > current) {
+        // best effort, the receive that noticed the drops should not fail because of this
+        (void) this->setReceiveBufferSize(next);
+    }
+}
+
 NetResult<size_t> UdpSocket::send(const void* buffer, size_t size) {
     return this->_send(buffer, size, sendFlags());
 }
@@ -89,6 +551,10 @@ NetResult<size_t> UdpSocket::recvFrom(void* buffer, size_t size, SocketAddressV6
     return result;
 }
 
+NetResult<size_t> UdpSocket::recvFrom(void* buffer, size_t size, UdpDestination& sender) {
+    return this->_recvFrom(buffer, size, sender, recvFlags());
+}
+
 NetResult<size_t> UdpSocket::recv(void* buffer, size_t size) {
     return this->_recv(buffer, size, recvFlags());
 }
@@ -134,7 +600,7 @@ NetResult<size_t> UdpSocket::_sendTo(const void* buffer, size_t size, const Sock
                           sa.asSockaddr(), sa.size());
 
     if (sent < 0) {
-        return Err(Error::lastOsError());
+        return Err(this->_sendError());
     }
 
     return Ok(static_cast<size_t>(sent));
@@ -144,7 +610,7 @@ NetResult<size_t> UdpSocket::_send(const void* buffer, size_t size, int flags) {
     auto sent = ::send(m_fd, static_cast<const char*>(buffer), size, flags);
 
     if (sent < 0) {
-        return Err(Error::lastOsError());
+        return Err(this->_sendError());
     }
 
     return Ok(static_cast<size_t>(sent));
@@ -176,5 +642,21 @@ NetResult<size_t> UdpSocket::_recvFrom(void* buffer, size_t size, SocketAddress&
     return Ok(static_cast<size_t>(received));
 }
 
+NetResult<size_t> UdpSocket::_recvFrom(void* buffer, size_t size, UdpDestination& sender, int flags) {
+    socklen_t addrLen = sizeof(sender.m_storage);
+
+    auto received = ::recvfrom(m_fd, static_cast<char*>(buffer), size, flags,
+                                  reinterpret_cast<sockaddr*>(sender.m_storage), &addrLen);
+
+    if (received < 0) {
+        return Err(Error::lastOsError());
+    }
+
+    sender.m_size = static_cast<uint32_t>(addrLen);
+    sender.m_mapped = false;
+
+    return Ok(static_cast<size_t>(received));
+}
+
 
 } // namespace qsox
@@ -1,6 +1,14 @@
 #include <qsox/BaseSocket.hpp>
+#include <qsox/SocketFilter.hpp>
+#include "Timestamping.hpp"
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <netinet/in.h>
+#include <errno.h>
+
+#ifdef __linux__
+# include <linux/filter.h>
+#endif
 
 namespace qsox {
 
@@ -26,4 +34,123 @@ NetResult<> BaseSocket::_setTimeout(int kind, uint32_t timeoutMs) {
     return mapResult(setsockopt(m_fd, SOL_SOCKET, kind, &tv, sizeof(tv)));
 }
 
+#ifdef __linux__
+
+static_assert(sizeof(SocketFilterInstruction) == sizeof(sock_filter));
+
+NetResult<> BaseSocket::attachFilter(const SocketFilter& filter) {
+    if (filter.size() == 0 || filter.size() > SocketFilter::MaxInstructions) {
+        return Err(Error::InvalidArgument);
+    }
+
+    sock_fprog program = {};
+    program.len = static_cast<unsigned short>(filter.size());
+    program.filter = reinterpret_cast<sock_filter*>(const_cast<SocketFilterInstruction*>(filter.instructions().data()));
+
+    return mapResult(setsockopt(m_fd, SOL_SOCKET, SO_ATTACH_FILTER, &program, sizeof(program)));
+}
+
+NetResult<> BaseSocket::detachFilter() {
+    int unused = 0;
+    return mapResult(setsockopt(m_fd, SOL_SOCKET, SO_DETACH_FILTER, &unused, sizeof(unused)));
+}
+
+NetResult<> BaseSocket::enableTimestamping(const TimestampingOptions& options) {
+    unsigned int flags = 0;
+
+    if (options.receive) {
+        flags |= SOF_TIMESTAMPING_RX_SOFTWARE | (options.hardware ? SOF_TIMESTAMPING_RX_HARDWARE : 0);
+    }
+
+    if (options.transmit) {
+        // OPT_ID ties each timestamp to a send, OPT_TSONLY avoids copying the sent packet back into the error queue
+        flags |= SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+        flags |= options.hardware ? SOF_TIMESTAMPING_TX_HARDWARE : 0;
+    }
+
+    if (flags != 0) {
+        flags |= SOF_TIMESTAMPING_SOFTWARE | (options.hardware ? SOF_TIMESTAMPING_RAW_HARDWARE : 0);
+    }
+
+    return mapResult(setsockopt(m_fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)));
+}
+
+NetResult<size_t> BaseSocket::readTxTimestamps(TxTimestamp* out, size_t maxCount) {
+    size_t count = 0;
+
+    while (count < maxCount) {
+        union {
+            cmsghdr align;
+            char data[TimestampControlSize + CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in6))];
+        } control;
+
+        msghdr msg = {};
+        msg.msg_control = control.data;
+        msg.msg_controllen = sizeof(control.data);
+
+        if (::recvmsg(m_fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+
+            return Err(Error::lastOsError());
+        }
+
+        // the entry is dequeued either way, report it instead of returning a partial timestamp
+        if (msg.msg_flags & MSG_CTRUNC) {
+            return Err(Error::MessageTooLong);
+        }
+
+        TxTimestamp entry;
+        bool hasTimestamp = false, hasId = false;
+
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (parseTimestampCmsg(cmsg, entry.timestamp)) {
+                hasTimestamp = true;
+                continue;
+            }
+
+            bool isRecvErr = (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_RECVERR)
+                || (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_RECVERR);
+
+            if (isRecvErr) {
+                sock_extended_err err;
+                memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+
+                if (err.ee_errno == ENOMSG && err.ee_origin == SO_EE_ORIGIN_TIMESTAMPING) {
+                    entry.id = err.ee_data;
+                    hasId = true;
+                }
+            }
+        }
+
+        // other errors (e.g. ICMP ones when IP_RECVERR is enabled) are skipped
+        if (hasTimestamp && hasId) {
+            out[count++] = entry;
+        }
+    }
+
+    return Ok(count);
+}
+
+#else
+
+NetResult<> BaseSocket::attachFilter(const SocketFilter& filter) {
+    return Err(Error::Unimplemented);
+}
+
+NetResult<> BaseSocket::detachFilter() {
+    return Err(Error::Unimplemented);
+}
+
+NetResult<> BaseSocket::enableTimestamping(const TimestampingOptions& options) {
+    return Err(Error::Unimplemented);
+}
+
+NetResult<size_t> BaseSocket::readTxTimestamps(TxTimestamp* out, size_t maxCount) {
+    return Err(Error::Unimplemented);
+}
+
+#endif
+
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "../MappedFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace qsox {
+
+NetResult<MappedFile> MappedFile::open(const std::filesystem::path& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return Err(Error::lastOsError(false));
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) == -1) {
+        auto err = Error::lastOsError(false);
+        ::close(fd);
+        return Err(err);
+    }
+
+    MappedFile file;
+    file.m_size = static_cast<size_t>(st.st_size);
+
+    // mapping an empty file fails, leave it as an empty mapping instead
+    if (file.m_size > 0) {
+        void* data = ::mmap(nullptr, file.m_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            auto err = Error::lastOsError(false);
+            ::close(fd);
+            return Err(err);
+        }
+
+        file.m_data = data;
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+
+    return Ok(std::move(file));
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        this->unmap();
+        m_data = other.m_data;
+        m_size = other.m_size;
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    this->unmap();
+}
+
+void MappedFile::unmap() {
+    if (m_data) {
+        ::munmap(const_cast<void*>(m_data), m_size);
+        m_data = nullptr;
+    }
+}
+
+} // namespace qsox
@@ -1,6 +1,7 @@
 #include <qsox/Poll.hpp>
 
 #include <poll.h>
+#include <chrono>
 
 namespace qsox {
 
@@ -19,26 +20,35 @@ NetResult<PollResult> pollOne(BaseSocket& socket, PollType poll, int timeoutMs)
         pfd.events |= POLLOUT;
     }
 
+    // a signal can interrupt the wait, after which only the time that is left should be waited for
+    auto start = timeoutMs > 0 ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+    int remainingMs = timeoutMs;
+
     while (true) {
-        int res = ::poll(&pfd, 1, timeoutMs);
+        int res = ::poll(&pfd, 1, remainingMs);
 
         if (res == 0) {
             return Ok(PollResult::Timeout);
         } else if (res == -1) {
             auto error = Error::lastOsError();
-            if (error.osCode() == EINTR) {
-                // interrupted by a signal, retry
-                continue;
-            } else {
+            if (error.osCode() != EINTR) {
                 return Err(error);
             }
+
+            // interrupted by a signal, retry with the time that is left
+            if (timeoutMs > 0) {
+                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+                if (elapsed >= timeoutMs) {
+                    return Ok(PollResult::Timeout);
+                }
+
+                remainingMs = timeoutMs - static_cast<int>(elapsed);
+            }
         } else if ((pfd.revents & (POLLHUP | POLLERR | POLLNVAL)) != 0) {
             return Err(socket.getSocketError());
         } else {
             break;
         }
-
-        // TODO: this should decrease interval when interrupted
     }
 
     if (pfd.revents & POLLIN) {
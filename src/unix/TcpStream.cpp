@@ -2,6 +2,7 @@
 #include <sys/poll.h>
 #include <chrono>
 #include "../SocketUtil.hpp"
+#include "Timestamping.hpp"
 
 using hclock = std::chrono::high_resolution_clock;
 
@@ -117,4 +118,40 @@ NetResult<void> TcpStream::shutdown(ShutdownMode mode) {
     return mapResult(::shutdown(m_fd, how));
 }
 
+NetResult<size_t> TcpStream::receive(void* buffer, size_t size, PacketTimestamp& timestamp) {
+    union {
+        cmsghdr align;
+        // room for other control messages enabled on the socket (e.g. TCP_INQ), so the timestamp isn't truncated
+        char data[TimestampControlSize + 64];
+    } control;
+
+    iovec iov = {buffer, size};
+
+    msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data;
+    msg.msg_controllen = sizeof(control.data);
+
+    auto received = ::recvmsg(m_fd, &msg, recvFlags());
+    if (received < 0) {
+        return Err(Error::lastOsError());
+    } else if (received == 0) {
+        return Err(Error::ConnectionClosed);
+    }
+
+    timestamp = {};
+
+    // the data is already consumed at this point, so a truncated timestamp is dropped rather than failing the receive
+    if (msg.msg_flags & MSG_CTRUNC) {
+        return Ok(static_cast<size_t>(received));
+    }
+
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        parseTimestampCmsg(cmsg, timestamp);
+    }
+
+    return Ok(static_cast<size_t>(received));
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <qsox/BaseSocket.hpp>
+#include <sys/socket.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+# include <linux/errqueue.h>
+# include <linux/net_tstamp.h>
+#endif
+
+namespace qsox {
+
+#ifdef SCM_TIMESTAMPING
+
+// Space needed for a SO_TIMESTAMPING control message
+constexpr size_t TimestampControlSize = CMSG_SPACE(sizeof(scm_timestamping));
+
+inline std::chrono::nanoseconds fromTimespec(const timespec& ts) {
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+// Reads the timestamps if the message is a SCM_TIMESTAMPING one, returns whether it was
+inline bool parseTimestampCmsg(const cmsghdr* cmsg, PacketTimestamp& out) {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_TIMESTAMPING) {
+        return false;
+    }
+
+    // cut short by a truncated control buffer (MSG_CTRUNC)
+    if (cmsg->cmsg_len < CMSG_LEN(sizeof(scm_timestamping))) {
+        return true;
+    }
+
+    // ts[0] is the software timestamp, ts[1] is unused, ts[2] is the raw hardware timestamp
+    scm_timestamping tss;
+    memcpy(&tss, CMSG_DATA(cmsg), sizeof(tss));
+
+    out.software = fromTimespec(tss.ts[0]);
+    out.hardware = fromTimespec(tss.ts[2]);
+
+    return true;
+}
+
+#else
+
+constexpr size_t TimestampControlSize = 0;
+
+inline bool parseTimestampCmsg(const cmsghdr* cmsg, PacketTimestamp& out) {
+    return false;
+}
+
+#endif
+
+} // namespace qsox
@@ -0,0 +1,300 @@
+#include <qsox/UdpSocket.hpp>
+#include "../SocketUtil.hpp"
+#include "Timestamping.hpp"
+#include <sys/ioctl.h>
+
+#ifdef __linux__
+# include <linux/sockios.h>
+# include <linux/sock_diag.h>
+#endif
+
+namespace qsox {
+
+// Large enough for one IPv4 and one IPv6 packet info message, a timestamp and a drop counter
+union PacketInfoControl {
+    cmsghdr align;
+    char data[CMSG_SPACE(sizeof(in_pktinfo)) + CMSG_SPACE(sizeof(in6_pktinfo)) + TimestampControlSize + CMSG_SPACE(sizeof(uint32_t))];
+};
+
+NetResult<> UdpSocket::enablePacketInfo(bool enable) {
+    int value = enable ? 1 : 0;
+
+#if defined(IP_PKTINFO) && defined(IPV6_RECVPKTINFO)
+    // on Linux, IP_PKTINFO works on IPv6 sockets too and covers IPv4 traffic on dual stack sockets
+    int res = setsockopt(m_fd, IPPROTO_IP, IP_PKTINFO, &value, sizeof(value));
+    if (res < 0 && !this->ipv6) {
+        return Err(Error::lastOsError());
+    }
+
+    if (this->ipv6) {
+        return mapResult(setsockopt(m_fd, IPPROTO_IPV6, IPV6_RECVPKTINFO, &value, sizeof(value)));
+    }
+
+    return Ok();
+#else
+    return Err(Error::Unimplemented);
+#endif
+}
+
+NetResult<> UdpSocket::enableDropReporting(bool enable) {
+#ifdef SO_RXQ_OVFL
+    int value = enable ? 1 : 0;
+    return mapResult(setsockopt(m_fd, SOL_SOCKET, SO_RXQ_OVFL, &value, sizeof(value)));
+#else
+    return Err(Error::Unimplemented);
+#endif
+}
+
+NetResult<UdpSocketStats> UdpSocket::stats() {
+    UdpSocketStats stats;
+
+#ifdef SO_MEMINFO
+    uint32_t meminfo[SK_MEMINFO_VARS] = {};
+    socklen_t len = sizeof(meminfo);
+
+    if (getsockopt(m_fd, SOL_SOCKET, SO_MEMINFO, meminfo, &len) < 0) {
+        return Err(Error::lastOsError());
+    }
+
+    stats.queuedBytes = meminfo[SK_MEMINFO_RMEM_ALLOC];
+    stats.receiveBufferSize = meminfo[SK_MEMINFO_RCVBUF];
+    stats.sendQueuedBytes = meminfo[SK_MEMINFO_WMEM_ALLOC];
+    stats.drops = meminfo[SK_MEMINFO_DROPS];
+
+    this->_noteDrops(stats.drops);
+#else
+    int pending = 0;
+    GEODE_UNWRAP(mapResult(::ioctl(m_fd, FIONREAD, &pending)));
+    GEODE_UNWRAP_INTO(stats.receiveBufferSize, this->receiveBufferSize());
+
+    stats.queuedBytes = static_cast<size_t>(pending);
+    stats.drops = m_lastDrops;
+#endif
+
+    return Ok(stats);
+}
+
+NetResult<size_t> UdpSocket::recvFrom(void* buffer, size_t size, UdpReceiveInfo& info) {
+    SockAddrAny addrStorage;
+    PacketInfoControl control;
+
+    iovec iov = {buffer, size};
+
+    msghdr msg = {};
+    msg.msg_name = addrStorage.asSockaddr();
+    msg.msg_namelen = addrStorage.maxSize();
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data;
+    msg.msg_controllen = sizeof(control.data);
+
+    auto received = ::recvmsg(m_fd, &msg, recvFlags());
+    if (received < 0) {
+        return Err(Error::lastOsError());
+    }
+
+    info.sender = addrStorage.toSocketAddress();
+    info.destination = this->ipv6 ? IpAddress{Ipv6Address::UNSPECIFIED} : IpAddress{Ipv4Address::UNSPECIFIED};
+    info.interfaceIndex = 0;
+    info.timestamp = {};
+    info.drops = 0;
+    bool hasDrops = false;
+
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (parseTimestampCmsg(cmsg, info.timestamp)) {
+            continue;
+        }
+
+#ifdef SO_RXQ_OVFL
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+            memcpy(&info.drops, CMSG_DATA(cmsg), sizeof(info.drops));
+            hasDrops = true;
+            continue;
+        }
+#endif
+
+#ifdef IP_PKTINFO
+        if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO) {
+            in_pktinfo pktinfo;
+            memcpy(&pktinfo, CMSG_DATA(cmsg), sizeof(pktinfo));
+
+            info.destination = Ipv4Address::fromInAddr(pktinfo.ipi_addr);
+            info.interfaceIndex = static_cast<uint32_t>(pktinfo.ipi_ifindex);
+        }
+#endif
+
+#ifdef IPV6_PKTINFO
+        if (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_PKTINFO) {
+            in6_pktinfo pktinfo;
+            memcpy(&pktinfo, CMSG_DATA(cmsg), sizeof(pktinfo));
+
+            info.destination = Ipv6Address::fromInAddr(pktinfo.ipi6_addr);
+            info.interfaceIndex = static_cast<uint32_t>(pktinfo.ipi6_ifindex);
+        }
+#endif
+    }
+
+    // IPv4 traffic on dual stack sockets is reported with IP_PKTINFO, use the same form as the sender
+    if (info.sender.isV6() && info.destination.isV4()) {
+        info.destination = Ipv6Address::fromIpv4Mapped(info.destination.asV4());
+    }
+
+    if (hasDrops) {
+        this->_noteDrops(info.drops);
+    }
+
+    return Ok(static_cast<size_t>(received));
+}
+
+NetResult<size_t> UdpSocket::sendTo(const void* buffer, size_t size, const SocketAddress& destination, const IpAddress& source, uint32_t interfaceIndex) {
+    return this->sendTo(buffer, size, this->prepareDestination(destination), source, interfaceIndex);
+}
+
+NetResult<size_t> UdpSocket::sendTo(const void* buffer, size_t size, const UdpDestination& destination, const IpAddress& source, uint32_t interfaceIndex) {
+    PacketInfoControl control;
+    memset(&control, 0, sizeof(control));
+
+    iovec iov = {const_cast<void*>(buffer), size};
+
+    msghdr msg = {};
+    msg.msg_name = const_cast<uint8_t*>(destination.m_storage);
+    msg.msg_namelen = destination.m_size;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data;
+
+    cmsghdr* cmsg = reinterpret_cast<cmsghdr*>(control.data);
+
+    // IPv4 traffic on dual stack sockets needs IP_PKTINFO, even if the source is given as an IPv4-mapped address
+    std::optional<Ipv4Address> sourceV4 = source.isV4() ? source.asV4() : source.asV6().toIpv4Mapped();
+
+    if (sourceV4) {
+#ifdef IP_PKTINFO
+        in_pktinfo pktinfo = {};
+        sourceV4->toInAddr(pktinfo.ipi_spec_dst);
+        pktinfo.ipi_ifindex = static_cast<int>(interfaceIndex);
+
+        cmsg->cmsg_level = IPPROTO_IP;
+        cmsg->cmsg_type = IP_PKTINFO;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(pktinfo));
+        memcpy(CMSG_DATA(cmsg), &pktinfo, sizeof(pktinfo));
+        msg.msg_controllen = CMSG_SPACE(sizeof(pktinfo));
+#else
+        return Err(Error::Unimplemented);
+#endif
+    } else {
+#ifdef IPV6_PKTINFO
+        in6_pktinfo pktinfo = {};
+        source.asV6().toInAddr(pktinfo.ipi6_addr);
+        pktinfo.ipi6_ifindex = interfaceIndex;
+
+        cmsg->cmsg_level = IPPROTO_IPV6;
+        cmsg->cmsg_type = IPV6_PKTINFO;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(pktinfo));
+        memcpy(CMSG_DATA(cmsg), &pktinfo, sizeof(pktinfo));
+        msg.msg_controllen = CMSG_SPACE(sizeof(pktinfo));
+#else
+        return Err(Error::Unimplemented);
+#endif
+    }
+
+    auto sent = ::sendmsg(m_fd, &msg, sendFlags());
+    if (sent < 0) {
+        return Err(this->_sendError());
+    }
+
+    return Ok(static_cast<size_t>(sent));
+}
+
+uint32_t UdpSocket::_queuedMtu() const {
+#ifdef IP_RECVERR
+    // an entry queued by an earlier send may be in front, so look a few entries further
+    for (int i = 0; i < 8; i++) {
+        union {
+            cmsghdr align;
+            char data[CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in6))];
+        } control;
+
+        msghdr msg = {};
+        msg.msg_control = control.data;
+        msg.msg_controllen = sizeof(control.data);
+
+        if (::recvmsg(m_fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            return 0;
+        }
+
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            bool isRecvErr = (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_RECVERR)
+                || (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_RECVERR);
+
+            if (!isRecvErr || cmsg->cmsg_len < CMSG_LEN(sizeof(sock_extended_err))) {
+                continue;
+            }
+
+            sock_extended_err err;
+            memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+
+            if (err.ee_errno == EMSGSIZE && err.ee_origin == SO_EE_ORIGIN_LOCAL) {
+                return err.ee_info;
+            }
+        }
+    }
+#endif
+
+    return 0;
+}
+
+NetResult<> UdpSocket::enableTxTime(TxTimeClock clock, bool reportErrors) {
+#ifdef SO_TXTIME
+    sock_txtime config = {};
+    config.clockid = clock == TxTimeClock::Tai ? CLOCK_TAI : CLOCK_MONOTONIC;
+    config.flags = reportErrors ? SOF_TXTIME_REPORT_ERRORS : 0;
+
+    return mapResult(setsockopt(m_fd, SOL_SOCKET, SO_TXTIME, &config, sizeof(config)));
+#else
+    return Err(Error::Unimplemented);
+#endif
+}
+
+NetResult<size_t> UdpSocket::sendAt(const void* buffer, size_t size, const SocketAddress& destination, std::chrono::nanoseconds txTime) {
+    return this->sendAt(buffer, size, this->prepareDestination(destination), txTime);
+}
+
+NetResult<size_t> UdpSocket::sendAt(const void* buffer, size_t size, const UdpDestination& destination, std::chrono::nanoseconds txTime) {
+#ifdef SCM_TXTIME
+    union {
+        cmsghdr align;
+        char data[CMSG_SPACE(sizeof(uint64_t))];
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    iovec iov = {const_cast<void*>(buffer), size};
+
+    msghdr msg = {};
+    msg.msg_name = const_cast<uint8_t*>(destination.m_storage);
+    msg.msg_namelen = destination.m_size;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data;
+    msg.msg_controllen = sizeof(control.data);
+
+    uint64_t time = static_cast<uint64_t>(txTime.count());
+
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_TXTIME;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(time));
+    memcpy(CMSG_DATA(cmsg), &time, sizeof(time));
+
+    auto sent = ::sendmsg(m_fd, &msg, sendFlags());
+    if (sent < 0) {
+        return Err(this->_sendError());
+    }
+
+    return Ok(static_cast<size_t>(sent));
+#else
+    return Err(Error::Unimplemented);
+#endif
+}
+
+} // namespace qsox
@@ -25,4 +25,20 @@ NetResult<> BaseSocket::_setTimeout(int kind, uint32_t timeoutMs) {
     );
 }
 
+NetResult<> BaseSocket::attachFilter(const SocketFilter& filter) {
+    return Err(Error::Unimplemented);
+}
+
+NetResult<> BaseSocket::detachFilter() {
+    return Err(Error::Unimplemented);
+}
+
+NetResult<> BaseSocket::enableTimestamping(const TimestampingOptions& options) {
+    return Err(Error::Unimplemented);
+}
+
+NetResult<size_t> BaseSocket::readTxTimestamps(TxTimestamp* out, size_t maxCount) {
+    return Err(Error::Unimplemented);
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "../MappedFile.hpp"
+
+#include <windows.h>
+
+namespace qsox {
+
+NetResult<MappedFile> MappedFile::open(const std::filesystem::path& path) {
+    HANDLE handle = CreateFileW(
+        path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+    );
+
+    if (handle == INVALID_HANDLE_VALUE) {
+        return Err(Error::lastOsError(false));
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size)) {
+        auto err = Error::lastOsError(false);
+        CloseHandle(handle);
+        return Err(err);
+    }
+
+    MappedFile file;
+    file.m_size = static_cast<size_t>(size.QuadPart);
+
+    // mapping an empty file fails, leave it as an empty mapping instead
+    if (file.m_size > 0) {
+        HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) {
+            auto err = Error::lastOsError(false);
+            CloseHandle(handle);
+            return Err(err);
+        }
+
+        const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!data) {
+            auto err = Error::lastOsError(false);
+            CloseHandle(mapping);
+            CloseHandle(handle);
+            return Err(err);
+        }
+
+        file.m_data = data;
+        file.m_mapping = mapping;
+    }
+
+    // the view keeps the file open
+    CloseHandle(handle);
+
+    return Ok(std::move(file));
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        this->unmap();
+        m_data = other.m_data;
+        m_size = other.m_size;
+        m_mapping = other.m_mapping;
+        other.m_data = nullptr;
+        other.m_size = 0;
+        other.m_mapping = nullptr;
+    }
+
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    this->unmap();
+}
+
+void MappedFile::unmap() {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+        m_data = nullptr;
+    }
+
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+}
+
+} // namespace qsox
@@ -95,4 +95,8 @@ NetResult<void> TcpStream::shutdown(ShutdownMode mode) {
     return mapResult(::shutdown(m_fd, how));
 }
 
+NetResult<size_t> TcpStream::receive(void* buffer, size_t size, PacketTimestamp& timestamp) {
+    return Err(Error::Unimplemented);
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include <qsox/UdpSocket.hpp>
+#include <WinSock2.h>
+
+namespace qsox {
+
+// Packet info needs WSARecvMsg/WSASendMsg, which are not wired up yet
+
+NetResult<> UdpSocket::enablePacketInfo(bool enable) {
+    return Err(Error::Unimplemented);
+}
+
+NetResult<> UdpSocket::enableDropReporting(bool enable) {
+    return Err(Error::Unimplemented);
+}
+
+NetResult<UdpSocketStats> UdpSocket::stats() {
+    UdpSocketStats stats;
+
+    u_long pending = 0;
+    if (::ioctlsocket(m_fd, FIONREAD, &pending) != 0) {
+        return Err(Error::lastOsError());
+    }
+
+    GEODE_UNWRAP_INTO(stats.receiveBufferSize, this->receiveBufferSize());
+
+    stats.queuedBytes = pending;
+    stats.drops = m_lastDrops;
+
+    return Ok(stats);
+}
+
+NetResult<size_t> UdpSocket::recvFrom(void* buffer, size_t size, UdpReceiveInfo& info) {
+    return Err(Error::Unimplemented);
+}
+
+NetResult<size_t> UdpSocket::sendTo(const void* buffer, size_t size, const SocketAddress& destination, const IpAddress& source, uint32_t interfaceIndex) {
+    return Err(Error::Unimplemented);
+}
+
+NetResult<size_t> UdpSocket::sendTo(const void* buffer, size_t size, const UdpDestination& destination, const IpAddress& source, uint32_t interfaceIndex) {
+    return Err(Error::Unimplemented);
+}
+
+uint32_t UdpSocket::_queuedMtu() const {
+    return 0;
+}
+
+NetResult<> UdpSocket::enableTxTime(TxTimeClock clock, bool reportErrors) {
+    return Err(Error::Unimplemented);
+}
+
+NetResult<size_t> UdpSocket::sendAt(const void* buffer, size_t size, const SocketAddress& destination, std::chrono::nanoseconds txTime) {
+    return Err(Error::Unimplemented);
+}
+
+NetResult<size_t> UdpSocket::sendAt(const void* buffer, size_t size, const UdpDestination& destination, std::chrono::nanoseconds txTime) {
+    return Err(Error::Unimplemented);
+}
+
+} // namespace qsox